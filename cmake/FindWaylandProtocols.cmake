@@ -23,10 +23,63 @@ ecm_add_wayland_client_protocol(WL_DEC_PROT_SRC
     BASENAME xdg-decoration-unstable-v1
     PRIVATE_CODE)
 
+ecm_add_wayland_client_protocol(WL_VIEWPORTER_PROT_SRC
+    PROTOCOL ${WAYLAND_PROTOCOLS_DIR}/stable/viewporter/viewporter.xml
+    BASENAME viewporter
+    PRIVATE_CODE)
+ecm_add_wayland_client_protocol(WL_SINGLE_PIXEL_BUFFER_PROT_SRC
+    PROTOCOL ${WAYLAND_PROTOCOLS_DIR}/staging/single-pixel-buffer/single-pixel-buffer-v1.xml
+    BASENAME single-pixel-buffer-v1
+    PRIVATE_CODE)
+ecm_add_wayland_client_protocol(WL_PRESENTATION_TIME_PROT_SRC
+    PROTOCOL ${WAYLAND_PROTOCOLS_DIR}/stable/presentation-time/presentation-time.xml
+    BASENAME presentation-time
+    PRIVATE_CODE)
+ecm_add_wayland_client_protocol(WL_TEARING_CONTROL_PROT_SRC
+    PROTOCOL ${WAYLAND_PROTOCOLS_DIR}/staging/tearing-control/tearing-control-v1.xml
+    BASENAME tearing-control-v1
+    PRIVATE_CODE)
+
+# fifo-v1 and commit-timing-v1 need wayland-protocols 1.38; without them the window
+# simply paces itself with frame callbacks alone.
+if(EXISTS ${WAYLAND_PROTOCOLS_DIR}/staging/fifo/fifo-v1.xml)
+    ecm_add_wayland_client_protocol(WL_FIFO_PROT_SRC
+        PROTOCOL ${WAYLAND_PROTOCOLS_DIR}/staging/fifo/fifo-v1.xml
+        BASENAME fifo-v1
+        PRIVATE_CODE)
+    set(WAYLAND_PROTOCOLS_HAS_FIFO TRUE)
+endif()
+if(EXISTS ${WAYLAND_PROTOCOLS_DIR}/staging/commit-timing/commit-timing-v1.xml)
+    ecm_add_wayland_client_protocol(WL_COMMIT_TIMING_PROT_SRC
+        PROTOCOL ${WAYLAND_PROTOCOLS_DIR}/staging/commit-timing/commit-timing-v1.xml
+        BASENAME commit-timing-v1
+        PRIVATE_CODE)
+    set(WAYLAND_PROTOCOLS_HAS_COMMIT_TIMING TRUE)
+endif()
+# cursor-shape-v1 (wayland-protocols 1.32) refers to tablet-v2 tools, so both are generated.
+if(EXISTS ${WAYLAND_PROTOCOLS_DIR}/staging/cursor-shape/cursor-shape-v1.xml)
+    ecm_add_wayland_client_protocol(WL_CURSOR_SHAPE_PROT_SRC
+        PROTOCOL ${WAYLAND_PROTOCOLS_DIR}/unstable/tablet/tablet-unstable-v2.xml
+        BASENAME tablet-unstable-v2
+        PRIVATE_CODE)
+    ecm_add_wayland_client_protocol(WL_CURSOR_SHAPE_PROT_SRC
+        PROTOCOL ${WAYLAND_PROTOCOLS_DIR}/staging/cursor-shape/cursor-shape-v1.xml
+        BASENAME cursor-shape-v1
+        PRIVATE_CODE)
+    set(WAYLAND_PROTOCOLS_HAS_CURSOR_SHAPE TRUE)
+endif()
+
 add_library(wayland_protocols
     STATIC
         ${WL_PROT_SRC}
         ${WL_DEC_PROT_SRC}
+        ${WL_VIEWPORTER_PROT_SRC}
+        ${WL_SINGLE_PIXEL_BUFFER_PROT_SRC}
+        ${WL_PRESENTATION_TIME_PROT_SRC}
+        ${WL_TEARING_CONTROL_PROT_SRC}
+        ${WL_FIFO_PROT_SRC}
+        ${WL_COMMIT_TIMING_PROT_SRC}
+        ${WL_CURSOR_SHAPE_PROT_SRC}
 )
 
 target_include_directories(wayland_protocols
@@ -1,3 +1,4 @@
+#include "main_loop.hpp"
 #include "window_manager.hpp"
 
 #include <cstdint>
@@ -11,13 +12,13 @@ int main() {
     auto window_manager = std::make_unique<tobi_engine::WindowManager>();
     auto window = window_manager->create_window(properties);
 
-    uint32_t c = 200;
-    
-    while(!window->should_close())
+    tobi_engine::MainLoop main_loop(*window_manager);
+
+    // Wake up at least every 16 ms, so application work runs without input.
+    while(!window->should_close() && main_loop.run_once(16))
     {
-        window->update();
     }
         
 
     return 0;
-}
\ No newline at end of file
+}
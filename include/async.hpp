@@ -0,0 +1,146 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace tobi_engine
+{
+
+    /**
+     * @class CoroutineExceptions
+     * @brief Exceptions that escaped a coroutine, kept until the main loop rethrows them.
+     *
+     * Coroutines are resumed from inside Wayland listeners, which an exception must never
+     * unwind through, so they are parked here instead and rethrown by
+     * WindowManager::update(). Safe to use from any thread.
+     */
+    class CoroutineExceptions
+    {
+    public:
+
+        static void store(std::exception_ptr exception) noexcept
+        {
+            std::lock_guard lock(mutex);
+            pending.push_back(std::move(exception));
+        }
+
+        /**
+         * @brief Rethrow the oldest stored exception, if any, and forget it.
+         */
+        static void rethrow()
+        {
+            std::exception_ptr exception;
+            {
+                std::lock_guard lock(mutex);
+                if (pending.empty())
+                    return;
+                exception = std::move(pending.front());
+                pending.erase(pending.begin());
+            }
+            std::rethrow_exception(exception);
+        }
+
+    private:
+
+        static inline std::mutex mutex;
+        static inline std::vector<std::exception_ptr> pending;
+    };
+
+    /**
+     * @class AsyncTask
+     * @brief Return type of fire-and-forget coroutines driven by the windowing events.
+     *
+     * The coroutine starts running right away and owns its own frame, which is freed
+     * when it finishes. Whenever it awaits a window or Wayland event it is resumed by
+     * the thread that dispatches that event, normally the main loop, so no extra threads
+     * are involved. An exception ends the coroutine and is handed to CoroutineExceptions,
+     * to be rethrown by WindowManager::update() on the main loop's thread.
+     *
+     *     tobi_engine::AsyncTask animate(tobi_engine::Window& window)
+     *     {
+     *         co_await window.configured();
+     *         while (!window.should_close())
+     *         {
+     *             co_await window.next_frame();
+     *             advance_animation();
+     *             window.request_redraw();
+     *         }
+     *     }
+     */
+    class AsyncTask
+    {
+    public:
+
+        struct promise_type
+        {
+            AsyncTask get_return_object() const noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { CoroutineExceptions::store(std::current_exception()); }
+        };
+    };
+
+    /**
+     * @class WaiterList
+     * @brief Coroutines suspended until an event happens.
+     *
+     * Only touched by the thread that dispatches the event. Coroutines still waiting when
+     * the list is destroyed are destroyed with it, since the event they wait for will
+     * never come; waiters are therefore expected to own their frames, like AsyncTask.
+     */
+    class WaiterList
+    {
+    public:
+
+        WaiterList() = default;
+        WaiterList(const WaiterList&) = delete;
+        WaiterList& operator=(const WaiterList&) = delete;
+        ~WaiterList()
+        {
+            for (auto handle : handles)
+                handle.destroy();
+        }
+
+        void add(std::coroutine_handle<> handle) { handles.push_back(handle); }
+        bool empty() const noexcept { return handles.empty(); }
+
+        /**
+         * @brief Resume every coroutine waiting right now.
+         * Coroutines that wait again while being resumed wait for the next event. Called
+         * from listeners, so an exception thrown by a resumed coroutine is handed to
+         * CoroutineExceptions instead of unwinding through the dispatch.
+         */
+        void resume_all() noexcept
+        {
+            // The two vectors trade places, so steady-state waiting allocates nothing.
+            std::vector<std::coroutine_handle<>> waiting;
+            waiting.swap(handles);
+            handles.swap(spare);
+
+            for (auto handle : waiting)
+            {
+                try
+                {
+                    handle.resume();
+                }
+                catch (...)
+                {
+                    CoroutineExceptions::store(std::current_exception());
+                }
+            }
+
+            waiting.clear();
+            spare.swap(waiting);
+        }
+
+    private:
+
+        std::vector<std::coroutine_handle<>> handles;
+        std::vector<std::coroutine_handle<>> spare;
+    };
+
+} // namespace tobi_engine
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "window_manager.hpp"
+
+#include <functional>
+
+namespace tobi_engine
+{
+
+    /**
+     * @class MainLoop
+     * @brief Drives event dispatch, window updates and application work.
+     *
+     * Each iteration waits on the compositor socket for at most the given timeout, or
+     * until work is posted through WindowManager::post(), dispatches whatever arrived,
+     * updates the windows and runs the update callback,
+     * so application work keeps running even when the compositor sends nothing.
+     */
+    class MainLoop
+    {
+    public:
+
+        explicit MainLoop(WindowManager& window_manager);
+        MainLoop(const MainLoop&) = delete;
+        MainLoop& operator=(const MainLoop&) = delete;
+        ~MainLoop() = default;
+
+        /**
+         * @brief Run one iteration.
+         * @param timeout_ms Milliseconds to wait for events; 0 polls, a negative value waits forever.
+         * @return False once the loop should end: stop() was called, every window closed or the connection failed.
+         */
+        bool run_once(int timeout_ms);
+
+        /**
+         * @brief Iterate until run_once() returns false.
+         * @param timeout_ms Upper bound on the time between two update callbacks.
+         */
+        void run(int timeout_ms = -1);
+
+        /**
+         * @brief End run() after the current iteration.
+         */
+        void stop();
+
+        /**
+         * @brief Application work run once per iteration, after events were dispatched.
+         */
+        void set_update_callback(std::function<void()> callback);
+
+    private:
+
+        WindowManager& window_manager;
+        std::function<void()> update_callback;
+        bool running = true;
+    };
+
+} // namespace tobi_engine
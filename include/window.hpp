@@ -1,15 +1,104 @@
 #pragma once
 
+#include "async.hpp"
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
 
 namespace tobi_engine
 {
+    /**
+     * @brief How a window times its redraws.
+     */
+    enum class FramePacing
+    {
+        /** Draw as soon as the compositor signals the previous frame was used; vsynced, no dropped commits. */
+        FrameCallback,
+        /** Draw as late as possible before the predicted next presentation, allowing tearing; lowest latency. */
+        LateLatch
+    };
+
     struct WindowProperties
     {
         uint32_t width;
         uint32_t height;
         std::string title;
+        /**
+         * @brief Dispatch this window's events on a thread of its own instead of the main loop.
+         */
+        bool threaded_dispatch = false;
+        FramePacing frame_pacing = FramePacing::FrameCallback;
+        /**
+         * @brief Release the window's pixel memory after this long without drawing; 0 never trims.
+         * Suspended windows are trimmed right away. Buffers are rebuilt on the next frame.
+         */
+        uint32_t idle_trim_timeout_ms = 5000;
+    };
+
+    /**
+     * @brief Presentation timing of a window's recent frames.
+     *
+     * Latencies run from the commit of a frame to the moment the compositor reports it
+     * on screen and cover the most recent frames only; counts cover the window's lifetime.
+     * Everything stays 0 when the compositor does not support presentation feedback.
+     */
+    struct FrameStatistics
+    {
+        uint64_t presented = 0;
+        uint64_t discarded = 0;
+        double refresh_interval_ms = 0.0;
+        double latency_p50_ms = 0.0;
+        double latency_p90_ms = 0.0;
+        double latency_p99_ms = 0.0;
+        double latency_max_ms = 0.0;
+    };
+
+    /**
+     * @brief Everything a pointer reported for one logical event, delivered at once.
+     *
+     * Motion only keeps the latest position and scrolling is summed, so a window sees
+     * one frame per compositor frame event however fast the mouse polls. Axis arrays
+     * are indexed by wl_pointer axis: 0 vertical, 1 horizontal.
+     */
+    struct PointerFrame
+    {
+        static constexpr size_t MAX_BUTTONS = 8;
+
+        struct Button
+        {
+            uint32_t button;
+            /** 0 for released, 1 for pressed */
+            uint32_t state;
+        };
+
+        uint32_t time = 0;
+
+        /** @brief Surface-local position; only meaningful when moved is set. */
+        bool moved = false;
+        double x = 0.0;
+        double y = 0.0;
+
+        /** @brief Button changes in the order they happened. */
+        std::array<Button, MAX_BUTTONS> buttons {};
+        uint32_t button_count = 0;
+
+        bool scrolled = false;
+        /** @brief Scroll distance in surface units. */
+        std::array<double, 2> axis {};
+        /** @brief Scroll in fractions of a wheel detent, 120 per detent; 0 for touchpads. */
+        std::array<int32_t, 2> axis_value120 {};
+        /** @brief Scrolling on this axis stopped, e.g. fingers lifted from a touchpad. */
+        std::array<bool, 2> axis_stop {};
+        /** @brief The content moves opposite to the fingers ("natural scrolling"). */
+        std::array<bool, 2> axis_inverted {};
+        /** @brief wl_pointer axis source: wheel, finger, continuous or wheel tilt. */
+        std::optional<uint32_t> axis_source;
+
+        bool empty() const noexcept { return !moved && button_count == 0 && !scrolled; }
     };
 
     class Window
@@ -25,16 +114,67 @@ namespace tobi_engine
 
         virtual void update() = 0;
         virtual bool should_close() = 0;
+
+        /**
+         * @brief Repaint the whole content of the window with the compositor's next frame.
+         * Requests made before that frame is due are merged into one redraw.
+         */
+        virtual void request_redraw() = 0;
+
+        virtual auto get_frame_statistics() const -> FrameStatistics = 0;
+
+        virtual void set_frame_pacing(FramePacing pacing) = 0;
+
+        /**
+         * @brief True once the compositor configured the window and its first frame was committed.
+         */
+        virtual bool is_configured() = 0;
+
+        struct FrameAwaiter
+        {
+            Window& window;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { window.wait_for_frame(handle); }
+            void await_resume() const noexcept {}
+        };
+
+        struct ConfigureAwaiter
+        {
+            Window& window;
+            bool await_ready() const { return window.is_configured(); }
+            void await_suspend(std::coroutine_handle<> handle) { window.wait_for_configure(handle); }
+            void await_resume() const noexcept {}
+        };
+
+        /**
+         * @brief Awaitable resumed when the compositor asks for the next frame.
+         * Resumed by the thread dispatching the window, like every window event, even when
+         * awaited from another thread.
+         */
+        auto next_frame() -> FrameAwaiter { return { *this }; }
+
+        /**
+         * @brief Awaitable resumed once the window is configured; ready right away afterwards.
+         */
+        auto configured() -> ConfigureAwaiter { return { *this }; }
         
         virtual void on_key(uint32_t key, uint32_t state) = 0;
 
         virtual void on_pointer_button(uint32_t button, uint32_t state) = 0;
         virtual void on_pointer_motion(int32_t x, int32_t y) = 0;
+        /**
+         * @brief Called once per pointer frame. By default reports the final position
+         * to on_pointer_motion() and then each button change to on_pointer_button().
+         */
+        virtual void on_pointer_frame(const PointerFrame& frame);
 
         auto get_uid() -> uint64_t;
 
     protected:
 
+        virtual void wait_for_frame(std::coroutine_handle<> handle) = 0;
+        virtual void wait_for_configure(std::coroutine_handle<> handle) = 0;
+
         WindowProperties properties;
 
     private:
@@ -2,6 +2,7 @@
 
 #include "window.hpp"
 
+#include <functional>
 #include <memory>
 
 namespace tobi_engine
@@ -18,6 +19,81 @@ namespace tobi_engine
 
         std::shared_ptr<Window> create_window(const WindowProperties& properties);
 
+        /**
+         * @brief Wait up to timeout_ms for compositor events and dispatch them.
+         * @param timeout_ms Milliseconds to wait; 0 polls, a negative value waits forever.
+         * @return False if the connection to the compositor failed.
+         */
+        bool dispatch(int timeout_ms);
+
+        /**
+         * @brief Run the deferred work of every window.
+         * @throws The oldest exception that escaped an AsyncTask since the last call.
+         */
+        void update();
+
+        /**
+         * @brief True once every window has been asked to close.
+         */
+        bool should_close() const;
+
+        /**
+         * @name External event loop integration
+         *
+         * Instead of dispatch(), an application with its own reactor polls get_fd() and
+         * get_wakeup_fd() itself:
+         *
+         *     auto events = manager.prepare_read();      // 0: connection lost
+         *     wait for events on get_fd(), POLLIN on get_wakeup_fd(),
+         *          at most get_timeout_ms()
+         *     get_fd() readable ? manager.read_events() : manager.cancel_read();
+         *     manager.update();
+         *
+         * Windows with a dispatch thread of their own are not affected.
+         * @{
+         */
+
+        /**
+         * @brief Descriptor of the compositor connection.
+         */
+        int get_fd() const;
+
+        /**
+         * @brief eventfd that becomes readable when work was posted to the loop's thread.
+         */
+        int get_wakeup_fd() const;
+
+        /**
+         * @brief Milliseconds until a window needs update() without any event, -1 if none does.
+         */
+        int get_timeout_ms() const;
+
+        /**
+         * @brief Dispatch queued events and flush requests before waiting on get_fd().
+         * @return The poll events to wait for on get_fd() (POLLIN, plus POLLOUT while
+         *         requests are still buffered), 0 if the connection failed.
+         */
+        short prepare_read();
+
+        /**
+         * @brief Read and dispatch events once get_fd() became readable after prepare_read().
+         * @return False if the connection failed.
+         */
+        bool read_events();
+
+        /**
+         * @brief Give up the read announced by prepare_read() when get_fd() was not readable.
+         */
+        void cancel_read();
+
+        /** @} */
+
+        /**
+         * @brief Run a task on the thread that drives the loop, without taking a lock.
+         * Safe to call from any thread; wakes up dispatch() or the external reactor.
+         */
+        void post(std::function<void()> task);
+
     private:
 
         std::shared_ptr<WindowRegistry> window_registry;
@@ -0,0 +1,505 @@
+#include "cursor_cache.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace tobi_engine
+{
+
+    namespace
+    {
+        constexpr uint32_t XCURSOR_MAGIC = 0x72756358; // "Xcur"
+        constexpr uint32_t XCURSOR_IMAGE_TYPE = 0xfffd0002;
+        constexpr uint32_t XCURSOR_IMAGE_HEADER_SIZE = 36;
+        constexpr uint32_t XCURSOR_MAX_IMAGE_SIZE = 0x7fff;
+        constexpr uint32_t XCURSOR_MAX_TOC = 0x10000;
+
+        constexpr uint32_t CACHE_MAGIC = 0x43424f54; // "TOBC"
+        constexpr uint32_t CACHE_VERSION = 1;
+        constexpr size_t CACHE_PIXEL_ALIGNMENT = 4096;
+
+        struct CacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t size;
+            uint32_t cursor_count;
+            uint32_t image_count;
+            uint32_t names_size;
+            int64_t theme_mtime;
+            uint64_t pixels_offset;
+            uint64_t pixels_size;
+        };
+
+        struct CacheCursor
+        {
+            uint32_t name_offset;
+            uint32_t name_length;
+            uint32_t first_image;
+            uint32_t image_count;
+        };
+
+        static_assert(sizeof(CacheHeader) == 48);
+        static_assert(sizeof(CacheCursor) == 16);
+        static_assert(sizeof(CursorImageInfo) == 32);
+
+        constexpr size_t align_up(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        // Xcursor files are little endian whatever the host.
+        auto read_u32(std::span<const uint8_t> data, size_t offset) -> std::optional<uint32_t>
+        {
+            if (offset > data.size() || data.size() - offset < 4)
+                return std::nullopt;
+            return uint32_t(data[offset]) | uint32_t(data[offset + 1]) << 8 |
+                   uint32_t(data[offset + 2]) << 16 | uint32_t(data[offset + 3]) << 24;
+        }
+
+        auto read_file(const std::filesystem::path& path) -> std::vector<uint8_t>
+        {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file)
+                return {};
+            std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            if (!file.read(reinterpret_cast<char*>(data.data()), data.size()))
+                return {};
+            return data;
+        }
+
+        /**
+         * @brief Append the images of the nominal size closest to size, in file order.
+         * @return The number of images appended; nothing is appended for a malformed file.
+         */
+        auto decode_xcursor(std::span<const uint8_t> file, uint32_t size,
+                            std::vector<CursorImageInfo>& images, std::vector<uint8_t>& pixels) -> uint32_t
+        {
+            auto magic = read_u32(file, 0);
+            auto header_size = read_u32(file, 4);
+            auto toc_count = read_u32(file, 12);
+            if (!magic || *magic != XCURSOR_MAGIC || !header_size || !toc_count || *toc_count > XCURSOR_MAX_TOC)
+                return 0;
+
+            auto distance = [size](uint32_t nominal) { return nominal > size ? nominal - size : size - nominal; };
+            auto toc_entry = [&](uint32_t index, uint32_t field) { return read_u32(file, *header_size + index * 12 + field * 4); };
+
+            std::optional<uint32_t> best;
+            for (uint32_t i = 0; i < *toc_count; ++i)
+            {
+                auto type = toc_entry(i, 0);
+                auto nominal = toc_entry(i, 1);
+                if (!type || !nominal)
+                    return 0;
+                if (*type == XCURSOR_IMAGE_TYPE && (!best || distance(*nominal) < distance(*best)))
+                    best = *nominal;
+            }
+            if (!best)
+                return 0;
+
+            auto first_image = images.size();
+            auto first_pixel = pixels.size();
+            auto rollback = [&]()
+            {
+                images.resize(first_image);
+                pixels.resize(first_pixel);
+                return 0;
+            };
+
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < *toc_count; ++i)
+            {
+                if (*toc_entry(i, 0) != XCURSOR_IMAGE_TYPE || *toc_entry(i, 1) != *best)
+                    continue;
+
+                auto position = toc_entry(i, 2);
+                if (!position)
+                    return rollback();
+                auto field = [&](uint32_t index) { return read_u32(file, size_t(*position) + index * 4); };
+
+                auto chunk_size = field(0);
+                auto width = field(4);
+                auto height = field(5);
+                auto hotspot_x = field(6);
+                auto hotspot_y = field(7);
+                auto delay = field(8);
+                if (!chunk_size || !width || !height || !hotspot_x || !hotspot_y || !delay ||
+                    *chunk_size < XCURSOR_IMAGE_HEADER_SIZE ||
+                    *width == 0 || *width > XCURSOR_MAX_IMAGE_SIZE || *height == 0 || *height > XCURSOR_MAX_IMAGE_SIZE ||
+                    *hotspot_x > *width || *hotspot_y > *height)
+                {
+                    return rollback();
+                }
+
+                CursorImageInfo image { *width, *height, *hotspot_x, *hotspot_y, *delay, 0, pixels.size() };
+                auto data = size_t(*position) + *chunk_size;
+                auto bytes = image.get_byte_size();
+                if (data > file.size() || file.size() - data < bytes)
+                    return rollback();
+
+                images.push_back(image);
+                pixels.insert(pixels.end(), file.begin() + data, file.begin() + data + bytes);
+                ++count;
+            }
+            return count;
+        }
+
+        auto get_env(const char* name) -> std::string
+        {
+            auto value = std::getenv(name);
+            return value ? value : "";
+        }
+
+        auto split(const std::string& list, const std::string& separators) -> std::vector<std::string>
+        {
+            std::vector<std::string> parts;
+            size_t start = 0;
+            while (start <= list.size())
+            {
+                auto end = list.find_first_of(separators, start);
+                if (end == std::string::npos)
+                    end = list.size();
+
+                auto part = list.substr(start, end - start);
+                auto first = part.find_first_not_of(" \t");
+                auto last = part.find_last_not_of(" \t\r");
+                if (first != std::string::npos)
+                    parts.push_back(part.substr(first, last - first + 1));
+                start = end + 1;
+            }
+            return parts;
+        }
+
+        auto get_search_path() -> std::vector<std::filesystem::path>
+        {
+            auto home = get_env("HOME");
+            std::vector<std::filesystem::path> search_path;
+
+            if (auto xcursor_path = get_env("XCURSOR_PATH"); !xcursor_path.empty())
+            {
+                for (auto& directory : split(xcursor_path, ":"))
+                {
+                    if (directory.starts_with("~/"))
+                        directory = home + directory.substr(1);
+                    search_path.emplace_back(directory);
+                }
+                return search_path;
+            }
+
+            auto data_home = get_env("XDG_DATA_HOME");
+            if (data_home.empty() && !home.empty())
+                data_home = home + "/.local/share";
+            if (!data_home.empty())
+                search_path.emplace_back(std::filesystem::path(data_home) / "icons");
+            if (!home.empty())
+                search_path.emplace_back(std::filesystem::path(home) / ".icons");
+
+            auto data_dirs = get_env("XDG_DATA_DIRS");
+            for (const auto& directory : split(data_dirs.empty() ? "/usr/local/share:/usr/share" : data_dirs, ":"))
+                search_path.emplace_back(std::filesystem::path(directory) / "icons");
+            search_path.emplace_back("/usr/share/pixmaps");
+            return search_path;
+        }
+
+        auto read_inherits(const std::filesystem::path& index) -> std::vector<std::string>
+        {
+            std::ifstream file(index);
+            std::string line;
+            while (std::getline(file, line))
+            {
+                if (!line.starts_with("Inherits"))
+                    continue;
+                if (auto equals = line.find('='); equals != std::string::npos)
+                    return split(line.substr(equals + 1), ",;");
+            }
+            return {};
+        }
+
+        void add_theme(const std::string& theme, const std::vector<std::filesystem::path>& search_path,
+                       std::unordered_set<std::string>& visited, std::vector<std::filesystem::path>& directories)
+        {
+            if (theme.empty() || !visited.insert(theme).second)
+                return;
+
+            std::error_code error;
+            std::vector<std::string> inherits;
+            for (const auto& base : search_path)
+            {
+                auto directory = base / theme;
+                if (std::filesystem::is_directory(directory / "cursors", error))
+                    directories.push_back(directory / "cursors");
+                if (inherits.empty() && std::filesystem::exists(directory / "index.theme", error))
+                    inherits = read_inherits(directory / "index.theme");
+            }
+
+            for (const auto& parent : inherits)
+                add_theme(parent, search_path, visited, directories);
+        }
+    }
+
+    CursorImageSet::CursorImageSet(CursorImageSet&& other) noexcept
+        : cursors(std::move(other.cursors)),
+          images(std::move(other.images)),
+          decoded(std::move(other.decoded)),
+          mapping(std::exchange(other.mapping, nullptr)),
+          mapping_size(std::exchange(other.mapping_size, 0)),
+          pixels(std::exchange(other.pixels, {}))
+    {
+    }
+
+    CursorImageSet& CursorImageSet::operator=(CursorImageSet&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            cursors = std::move(other.cursors);
+            images = std::move(other.images);
+            decoded = std::move(other.decoded);
+            mapping = std::exchange(other.mapping, nullptr);
+            mapping_size = std::exchange(other.mapping_size, 0);
+            pixels = std::exchange(other.pixels, {});
+        }
+        return *this;
+    }
+
+    CursorImageSet::~CursorImageSet()
+    {
+        unmap();
+    }
+
+    void CursorImageSet::unmap() noexcept
+    {
+        if (mapping)
+            munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+
+    auto CursorImageSet::decode(const std::vector<std::filesystem::path>& directories, uint32_t size) -> CursorImageSet
+    {
+        CursorImageSet set;
+
+        // Most cursor names are symlinks to a few files; decode each file once.
+        std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> decoded_files;
+        std::unordered_set<std::string> names;
+
+        for (const auto& directory : directories)
+        {
+            std::error_code error;
+            for (std::filesystem::directory_iterator entry(directory, error), end; !error && entry != end; entry.increment(error))
+            {
+                auto name = entry->path().filename().string();
+                if (names.contains(name))
+                    continue;
+
+                std::error_code target_error;
+                auto target = std::filesystem::canonical(entry->path(), target_error);
+                if (target_error)
+                    continue;
+
+                auto [file, inserted] = decoded_files.try_emplace(target.string());
+                if (inserted)
+                {
+                    auto first_image = static_cast<uint32_t>(set.images.size());
+                    auto count = decode_xcursor(read_file(target), size, set.images, set.decoded);
+                    file->second = { first_image, count };
+                }
+
+                auto [first_image, count] = file->second;
+                if (count == 0)
+                    continue;
+                names.insert(name);
+                set.cursors.push_back({ std::move(name), first_image, count });
+            }
+        }
+
+        set.pixels = set.decoded;
+        LOG_DEBUG("Decoded {} cursors with {} images from {} files", set.cursors.size(), set.images.size(), decoded_files.size());
+        return set;
+    }
+
+    auto CursorImageSet::map(const std::filesystem::path& path, uint32_t size, int64_t theme_mtime) -> std::optional<CursorImageSet>
+    {
+        int file_descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file_descriptor == -1)
+            return std::nullopt;
+
+        struct stat file_stat {};
+        if (fstat(file_descriptor, &file_stat) == -1 || static_cast<size_t>(file_stat.st_size) < sizeof(CacheHeader))
+        {
+            close(file_descriptor);
+            return std::nullopt;
+        }
+
+        auto file_size = static_cast<size_t>(file_stat.st_size);
+        auto mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        close(file_descriptor);
+        if (mapping == MAP_FAILED)
+            return std::nullopt;
+
+        CursorImageSet set;
+        set.mapping = mapping;
+        set.mapping_size = file_size;
+        auto bytes = static_cast<const uint8_t*>(mapping);
+
+        CacheHeader header;
+        std::memcpy(&header, bytes, sizeof(header));
+        if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+            header.size != size || header.theme_mtime != theme_mtime)
+        {
+            LOG_DEBUG("Cursor cache {} is stale", path.string());
+            return std::nullopt;
+        }
+
+        auto cursors_offset = sizeof(CacheHeader);
+        auto images_offset = cursors_offset + size_t(header.cursor_count) * sizeof(CacheCursor);
+        auto names_offset = images_offset + size_t(header.image_count) * sizeof(CursorImageInfo);
+        if (names_offset + header.names_size > header.pixels_offset ||
+            header.pixels_offset > file_size || header.pixels_size > file_size - header.pixels_offset)
+        {
+            LOG_WARNING("Cursor cache {} is damaged", path.string());
+            return std::nullopt;
+        }
+
+        set.images.resize(header.image_count);
+        std::memcpy(set.images.data(), bytes + images_offset, set.images.size() * sizeof(CursorImageInfo));
+        for (const auto& image : set.images)
+        {
+            if (image.offset > header.pixels_size || image.get_byte_size() > header.pixels_size - image.offset)
+            {
+                LOG_WARNING("Cursor cache {} is damaged", path.string());
+                return std::nullopt;
+            }
+        }
+
+        auto names = reinterpret_cast<const char*>(bytes + names_offset);
+        set.cursors.reserve(header.cursor_count);
+        for (uint32_t i = 0; i < header.cursor_count; ++i)
+        {
+            CacheCursor cursor;
+            std::memcpy(&cursor, bytes + cursors_offset + i * sizeof(CacheCursor), sizeof(cursor));
+            if (cursor.name_offset > header.names_size || cursor.name_length > header.names_size - cursor.name_offset ||
+                cursor.first_image > header.image_count || cursor.image_count > header.image_count - cursor.first_image)
+            {
+                LOG_WARNING("Cursor cache {} is damaged", path.string());
+                return std::nullopt;
+            }
+            set.cursors.push_back({ std::string(names + cursor.name_offset, cursor.name_length), cursor.first_image, cursor.image_count });
+        }
+
+        set.pixels = { bytes + header.pixels_offset, header.pixels_size };
+        return set;
+    }
+
+    bool CursorImageSet::write(const std::filesystem::path& path, uint32_t size, int64_t theme_mtime) const
+    {
+        std::string names;
+        std::vector<CacheCursor> entries;
+        entries.reserve(cursors.size());
+        for (const auto& cursor : cursors)
+        {
+            entries.push_back({ static_cast<uint32_t>(names.size()), static_cast<uint32_t>(cursor.name.size()),
+                                cursor.first_image, cursor.image_count });
+            names += cursor.name;
+        }
+
+        auto metadata_size = sizeof(CacheHeader) + entries.size() * sizeof(CacheCursor) +
+                             images.size() * sizeof(CursorImageInfo) + names.size();
+
+        CacheHeader header {
+            CACHE_MAGIC, CACHE_VERSION, size,
+            static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(images.size()), static_cast<uint32_t>(names.size()),
+            theme_mtime, align_up(metadata_size, CACHE_PIXEL_ALIGNMENT), pixels.size()
+        };
+
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+
+        // Concurrent writers each use their own file; the last rename wins.
+        auto temporary = path;
+        temporary += ".tmp-" + std::to_string(getpid());
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            std::vector<char> padding(header.pixels_offset - metadata_size, 0);
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(CacheCursor));
+            file.write(reinterpret_cast<const char*>(images.data()), images.size() * sizeof(CursorImageInfo));
+            file.write(names.data(), names.size());
+            file.write(padding.data(), padding.size());
+            file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+
+            if (!file.flush())
+            {
+                LOG_WARNING("Failed to write cursor cache {}", temporary.string());
+                file.close();
+                std::filesystem::remove(temporary, error);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temporary, path, error);
+        if (error)
+        {
+            LOG_WARNING("Failed to replace cursor cache {}: {}", path.string(), error.message());
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+
+        LOG_DEBUG("Wrote cursor cache {} with {} bytes of pixels", path.string(), pixels.size());
+        return true;
+    }
+
+    auto find_cursor_directories(const std::string& theme) -> std::vector<std::filesystem::path>
+    {
+        std::unordered_set<std::string> visited;
+        std::vector<std::filesystem::path> directories;
+        add_theme(theme, get_search_path(), visited, directories);
+        return directories;
+    }
+
+    auto get_directories_mtime(const std::vector<std::filesystem::path>& directories) -> int64_t
+    {
+        // Installing or removing cursors touches their directory, as does a package update
+        // replacing the files.
+        int64_t latest = 0;
+        for (const auto& directory : directories)
+        {
+            std::error_code error;
+            auto time = std::filesystem::last_write_time(directory, error);
+            if (!error)
+                latest = std::max<int64_t>(latest, std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+        }
+        return latest;
+    }
+
+    auto get_cursor_cache_path(const std::string& theme, uint32_t size) -> std::filesystem::path
+    {
+        std::filesystem::path base = get_env("XDG_CACHE_HOME");
+        if (base.empty() || base.is_relative())
+        {
+            auto home = get_env("HOME");
+            if (home.empty())
+                return {};
+            base = std::filesystem::path(home) / ".cache";
+        }
+
+        auto file_name = theme;
+        std::replace(file_name.begin(), file_name.end(), '/', '_');
+        return base / "tobi_engine" / "cursors" / (file_name + "-" + std::to_string(size) + ".cache");
+    }
+
+} // namespace tobi_engine
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace tobi_engine
+{
+
+    /**
+     * @brief One decoded cursor image; pixels are premultiplied ARGB8888 rows without padding.
+     * Also the on-disk layout of an image in a cache file.
+     */
+    struct CursorImageInfo
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t hotspot_x = 0;
+        uint32_t hotspot_y = 0;
+        /** @brief Milliseconds to show this image before the next one of an animation. */
+        uint32_t delay = 0;
+        uint32_t reserved = 0;
+        /** @brief Offset of the pixels from the start of the pixel blob. */
+        uint64_t offset = 0;
+
+        auto get_byte_size() const noexcept -> size_t { return size_t(width) * height * 4; }
+    };
+
+    /**
+     * @brief A named cursor: a run of consecutive images, more than one when animated.
+     * Aliases of the same Xcursor file share their images.
+     */
+    struct CursorInfo
+    {
+        std::string name;
+        uint32_t first_image = 0;
+        uint32_t image_count = 0;
+    };
+
+    /**
+     * @class CursorImageSet
+     * @brief Every cursor of a theme at one size, decoded into a single contiguous pixel blob.
+     *
+     * Decoding walks the theme's Xcursor files, which is what makes loading a theme
+     * slow. The result can be written to a cache file and mapped back on the next
+     * start; the pixel blob sits page aligned in that file so it can be copied into
+     * an SHM arena in one go.
+     */
+    class CursorImageSet
+    {
+    public:
+
+        CursorImageSet() = default;
+        CursorImageSet(CursorImageSet&& other) noexcept;
+        CursorImageSet& operator=(CursorImageSet&& other) noexcept;
+        CursorImageSet(const CursorImageSet&) = delete;
+        CursorImageSet& operator=(const CursorImageSet&) = delete;
+        ~CursorImageSet();
+
+        /**
+         * @brief Decode the Xcursor files of a theme, picking the nominal size closest to size.
+         * @param directories The theme's cursors directories, earlier ones taking precedence.
+         */
+        static auto decode(const std::vector<std::filesystem::path>& directories, uint32_t size) -> CursorImageSet;
+
+        /**
+         * @brief Map a cache file written by write().
+         * @return The set, or nullopt when the file is missing, damaged or was written
+         *         for another size or theme modification time.
+         */
+        static auto map(const std::filesystem::path& path, uint32_t size, int64_t theme_mtime) -> std::optional<CursorImageSet>;
+
+        /**
+         * @brief Write the set to a cache file, replacing it atomically.
+         */
+        bool write(const std::filesystem::path& path, uint32_t size, int64_t theme_mtime) const;
+
+        auto get_cursors() const noexcept -> const std::vector<CursorInfo>& { return cursors; }
+        auto get_images() const noexcept -> const std::vector<CursorImageInfo>& { return images; }
+        auto get_pixels() const noexcept -> std::span<const uint8_t> { return pixels; }
+        bool empty() const noexcept { return cursors.empty(); }
+
+    private:
+
+        void unmap() noexcept;
+
+        std::vector<CursorInfo> cursors;
+        std::vector<CursorImageInfo> images;
+
+        /** @brief Pixels of a decoded set; a mapped set points pixels into the mapping instead. */
+        std::vector<uint8_t> decoded;
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+        std::span<const uint8_t> pixels;
+    };
+
+    /**
+     * @brief The cursors directories of a theme and the themes it inherits, in lookup order.
+     * Searched in XCURSOR_PATH, or the XDG icon directories when it is not set.
+     */
+    auto find_cursor_directories(const std::string& theme) -> std::vector<std::filesystem::path>;
+
+    /**
+     * @brief Latest modification time of a set of directories, 0 when none can be read.
+     */
+    auto get_directories_mtime(const std::vector<std::filesystem::path>& directories) -> int64_t;
+
+    /**
+     * @brief Cache file of a theme at one size under $XDG_CACHE_HOME, empty without a cache directory.
+     */
+    auto get_cursor_cache_path(const std::string& theme, uint32_t size) -> std::filesystem::path;
+
+} // namespace tobi_engine
@@ -0,0 +1,95 @@
+#include "damage_region.hpp"
+
+#include <limits>
+
+namespace tobi_engine
+{
+
+    namespace
+    {
+        // Area that would be repainted needlessly if the two rectangles were merged.
+        constexpr int64_t merge_waste(const Rect& a, const Rect& b) noexcept
+        {
+            return a.united(b).area() - a.area() - b.area() + a.intersected(b).area();
+        }
+    }
+
+    void DamageRegion::add(const Rect& rect) noexcept
+    {
+        if (rect.empty())
+            return;
+
+        auto merged = rect;
+
+        // Absorb everything the new rectangle covers or can be merged with for free,
+        // repeating since a grown rectangle may now reach further neighbours.
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (rectangles[i].contains(merged))
+                    return;
+
+                if (merged.contains(rectangles[i]) || (merged.touches(rectangles[i]) && merge_waste(merged, rectangles[i]) <= 0))
+                {
+                    merged = merged.united(rectangles[i]);
+                    remove(i);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+
+        rectangles[count++] = merged;
+
+        if (count > MAX_RECTS)
+            merge_cheapest_pair();
+    }
+
+    void DamageRegion::add(const DamageRegion& region) noexcept
+    {
+        for (const auto& rect : region.rects())
+            add(rect);
+    }
+
+    auto DamageRegion::bounds() const noexcept -> Rect
+    {
+        Rect result;
+        for (const auto& rect : rects())
+            result = result.united(rect);
+        return result;
+    }
+
+    void DamageRegion::merge_cheapest_pair() noexcept
+    {
+        size_t first = 0;
+        size_t second = 1;
+        auto lowest = std::numeric_limits<int64_t>::max();
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (size_t j = i + 1; j < count; ++j)
+            {
+                auto waste = merge_waste(rectangles[i], rectangles[j]);
+                if (waste < lowest)
+                {
+                    lowest = waste;
+                    first = i;
+                    second = j;
+                }
+            }
+        }
+
+        auto merged = rectangles[first].united(rectangles[second]);
+        remove(second);
+        remove(first);
+        add(merged);
+    }
+
+    void DamageRegion::remove(size_t index) noexcept
+    {
+        rectangles[index] = rectangles[--count];
+    }
+
+} // namespace tobi_engine
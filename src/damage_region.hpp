@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace tobi_engine
+{
+
+    /**
+     * @brief Axis aligned rectangle in buffer coordinates.
+     */
+    struct Rect
+    {
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t width = 0;
+        int32_t height = 0;
+
+        constexpr bool empty() const noexcept { return width <= 0 || height <= 0; }
+        constexpr int64_t area() const noexcept { return empty() ? 0 : int64_t(width) * height; }
+        constexpr int32_t right() const noexcept { return x + width; }
+        constexpr int32_t bottom() const noexcept { return y + height; }
+
+        constexpr bool contains(const Rect& other) const noexcept
+        {
+            return other.x >= x && other.y >= y && other.right() <= right() && other.bottom() <= bottom();
+        }
+
+        /**
+         * @brief True if the rectangles overlap or share an edge.
+         */
+        constexpr bool touches(const Rect& other) const noexcept
+        {
+            return other.x <= right() && x <= other.right() && other.y <= bottom() && y <= other.bottom();
+        }
+
+        constexpr Rect united(const Rect& other) const noexcept
+        {
+            if (empty())
+                return other;
+            if (other.empty())
+                return *this;
+            auto left = std::min(x, other.x);
+            auto top = std::min(y, other.y);
+            return { left, top, std::max(right(), other.right()) - left, std::max(bottom(), other.bottom()) - top };
+        }
+
+        constexpr Rect intersected(const Rect& other) const noexcept
+        {
+            auto left = std::max(x, other.x);
+            auto top = std::max(y, other.y);
+            auto width = std::min(right(), other.right()) - left;
+            auto height = std::min(bottom(), other.bottom()) - top;
+            if (width <= 0 || height <= 0)
+                return {};
+            return { left, top, width, height };
+        }
+
+        constexpr bool operator==(const Rect&) const noexcept = default;
+    };
+
+    /**
+     * @class DamageRegion
+     * @brief Small list of dirty rectangles.
+     *
+     * Added rectangles are merged with neighbours when that wastes little area, and
+     * the list is capped at MAX_RECTS by merging the cheapest pair, so the number of
+     * rectangles repainted and sent to the compositor stays bounded.
+     */
+    class DamageRegion
+    {
+    public:
+
+        static constexpr size_t MAX_RECTS = 8;
+
+        void add(const Rect& rect) noexcept;
+        void add(const DamageRegion& region) noexcept;
+        void clear() noexcept { count = 0; }
+
+        bool empty() const noexcept { return count == 0; }
+        auto rects() const noexcept -> std::span<const Rect> { return { rectangles.data(), count }; }
+        auto bounds() const noexcept -> Rect;
+
+    private:
+
+        void merge_cheapest_pair() noexcept;
+        void remove(size_t index) noexcept;
+
+        std::array<Rect, MAX_RECTS + 1> rectangles{};
+        size_t count = 0;
+    };
+
+} // namespace tobi_engine
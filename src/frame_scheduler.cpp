@@ -0,0 +1,202 @@
+#include "frame_scheduler.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace tobi_engine
+{
+
+    FrameScheduler::FrameScheduler(DrawFunction draw, const FrameTimeline& timeline, clockid_t clock)
+        :   draw(std::move(draw)),
+            timeline(timeline),
+            clock(clock)
+    {
+    }
+
+    void FrameScheduler::request_redraw()
+    {
+        dirty = true;
+        if (suspended || is_waiting() || deadline_ns)
+            return;
+
+        schedule();
+    }
+
+    void FrameScheduler::request_urgent_redraw()
+    {
+        request_redraw();
+        if (suspended || !is_waiting() || deadline_ns)
+            return;
+
+        auto refresh_ns = timeline.get_refresh_ns();
+        deadline_ns = now() + (refresh_ns ? refresh_ns : DEFAULT_REFRESH_NS);
+        urgent = true;
+    }
+
+    void FrameScheduler::update()
+    {
+        if (!deadline_ns || now() < deadline_ns)
+            return;
+
+        deadline_ns = 0;
+        urgent = false;
+        dirty = false;
+        run_draw();
+    }
+
+    int FrameScheduler::get_timeout_ms() const
+    {
+        if (!deadline_ns)
+            return -1;
+
+        auto current = now();
+        if (current >= deadline_ns)
+            return 0;
+        // Round up, waking early would only mean another wait.
+        return static_cast<int>((deadline_ns - current + 999'999) / 1'000'000);
+    }
+
+    void FrameScheduler::arm(wl_surface* surface)
+    {
+        // A suspended window would not get the callback anyway.
+        if (suspended || is_waiting())
+            return;
+
+        request_callback(surface);
+        waiting = true;
+    }
+
+    void FrameScheduler::request_callback(wl_surface* surface)
+    {
+        static constexpr wl_callback_listener frame_listener
+        {
+            &FrameScheduler::frame_done
+        };
+
+        callback.reset(wl_surface_frame(surface));
+        wl_callback_add_listener(callback.get(), &frame_listener, this);
+    }
+
+    void FrameScheduler::reset()
+    {
+        callback.reset();
+        waiting = false;
+    }
+
+    void FrameScheduler::wait_for_frame(std::coroutine_handle<> handle)
+    {
+        frame_waiters.add(handle);
+
+        // Without an outstanding callback, one is only requested by the next commit.
+        if (!is_waiting())
+            request_redraw();
+    }
+
+    void FrameScheduler::set_suspended(bool suspended)
+    {
+        if (suspended == this->suspended)
+            return;
+        this->suspended = suspended;
+
+        if (suspended)
+        {
+            // The request stays dirty and is replayed on resume.
+            if (deadline_ns)
+                dirty = true;
+            deadline_ns = 0;
+            urgent = false;
+            return;
+        }
+
+        // A callback requested before the suspension may only fire once the window is
+        // shown again, which is exactly what the next frame is needed for.
+        reset();
+        if (dirty)
+            schedule();
+    }
+
+    void FrameScheduler::set_pacing(FramePacing pacing)
+    {
+        this->pacing = pacing;
+
+        // A pending deadline belongs to the old mode; reschedule under the new one.
+        if (deadline_ns && !suspended)
+        {
+            deadline_ns = 0;
+            urgent = false;
+            schedule();
+        }
+    }
+
+    void FrameScheduler::frame_done(void *data, wl_callback *callback, uint32_t time)
+    {
+        static_cast<FrameScheduler*>(data)->on_frame_done(time);
+    }
+
+    void FrameScheduler::on_frame_done(uint32_t time)
+    {
+        reset();
+        last_frame_time = time;
+
+        // The callback came after all, so the backup deadline is not needed.
+        if (urgent)
+        {
+            deadline_ns = 0;
+            urgent = false;
+        }
+
+        // Waiters typically prepare the next frame and request a redraw, which the
+        // check below then serves.
+        frame_waiters.resume_all();
+
+        // Requests made since the last frame were deferred to this point.
+        if (dirty && !deadline_ns && !suspended)
+            schedule();
+    }
+
+    void FrameScheduler::schedule()
+    {
+        if (pacing == FramePacing::LateLatch)
+        {
+            // Aim for the first presentation that can still be reached, and start drawing
+            // as late as the slowest recent draw allows.
+            auto current = now();
+            auto lead = render_estimate() + COMPOSITOR_MARGIN_NS;
+            if (auto target = timeline.predict_presentation(current + lead))
+            {
+                target_presentation_ns = target;
+                deadline_ns = target - lead;
+                update();
+                return;
+            }
+            // Without presentation feedback there is nothing to predict from.
+        }
+
+        dirty = false;
+        run_draw();
+    }
+
+    void FrameScheduler::run_draw()
+    {
+        auto start = now();
+        draw();
+        render_durations[render_index] = now() - start;
+        render_index = (render_index + 1) % RENDER_HISTORY;
+        target_presentation_ns = 0;
+    }
+
+    uint64_t FrameScheduler::now() const
+    {
+        timespec time{};
+        clock_gettime(clock, &time);
+        return uint64_t(time.tv_sec) * 1'000'000'000 + uint64_t(time.tv_nsec);
+    }
+
+    uint64_t FrameScheduler::render_estimate() const
+    {
+        return *std::max_element(render_durations.begin(), render_durations.end());
+    }
+
+} // namespace tobi_engine
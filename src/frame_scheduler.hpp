@@ -0,0 +1,151 @@
+#pragma once
+
+#include "async.hpp"
+#include "frame_timeline.hpp"
+#include "wayland_types.hpp"
+#include "window.hpp"
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+
+namespace tobi_engine
+{
+
+    /**
+     * @class FrameScheduler
+     * @brief Paces the redraws of one window to the compositor's frame callbacks.
+     *
+     * A redraw request only marks the window dirty. If no frame callback is outstanding
+     * the window is drawn right away; otherwise the draw waits for the callback, so any
+     * number of requests in between collapse into a single frame. Every committed frame
+     * re-arms the callback, and since hidden or occluded windows receive none, they stop
+     * drawing until the compositor shows them again.
+     *
+     * With FramePacing::LateLatch the draw is further delayed to a deadline just before
+     * the predicted next presentation, leaving room for the longest recent draw and the
+     * compositor's own latch, so the frame shows input that is as fresh as possible.
+     * The owner calls update() once the deadline returned by get_timeout_ms() expires.
+     */
+    class FrameScheduler
+    {
+    public:
+
+        using DrawFunction = std::function<void()>;
+
+        /**
+         * @param draw Draws and commits the window; expected to call arm() before committing.
+         * @param timeline Presentation history used to predict the next presentation.
+         * @param clock Clock of the presentation timestamps.
+         */
+        FrameScheduler(DrawFunction draw, const FrameTimeline& timeline, clockid_t clock);
+        FrameScheduler(const FrameScheduler&) = delete;
+        FrameScheduler& operator=(const FrameScheduler&) = delete;
+        virtual ~FrameScheduler() = default;
+
+        /**
+         * @brief Mark the window dirty and draw it as soon as the compositor is ready.
+         */
+        void request_redraw();
+
+        /**
+         * @brief Like request_redraw(), but draw within one refresh interval even if the
+         *        outstanding frame callback does not fire, as it may not for occluded windows.
+         */
+        void request_urgent_redraw();
+
+        /**
+         * @brief Draw if a late-latch deadline has passed.
+         */
+        void update();
+
+        /**
+         * @brief Milliseconds until update() has work to do, -1 if nothing is scheduled.
+         */
+        int get_timeout_ms() const;
+
+        /**
+         * @brief Request a frame callback with the next commit of surface.
+         * Does nothing while a callback is already outstanding.
+         */
+        void arm(wl_surface* surface);
+
+        /**
+         * @brief Forget an outstanding callback, e.g. when its surface is destroyed.
+         */
+        void reset();
+
+        /**
+         * @brief Resume handle with the next frame callback, drawing to request one if needed.
+         */
+        void wait_for_frame(std::coroutine_handle<> handle);
+        bool has_frame_waiters() const { return !frame_waiters.empty(); }
+
+        /**
+         * @brief Stop drawing while the compositor has suspended the window.
+         * Redraw requests are remembered and served once the window is resumed.
+         */
+        void set_suspended(bool suspended);
+        bool is_suspended() const { return suspended; }
+
+        void set_pacing(FramePacing pacing);
+        FramePacing get_pacing() const { return pacing; }
+
+        bool is_waiting() const { return waiting; }
+
+        /**
+         * @brief Predicted presentation time of the frame being drawn, 0 if unknown.
+         */
+        uint64_t get_target_presentation() const { return target_presentation_ns; }
+
+        /**
+         * @brief Timestamp in milliseconds of the last frame callback, 0 before the first.
+         */
+        uint32_t get_last_frame_time() const { return last_frame_time; }
+
+    protected:
+
+        /**
+         * @brief Create the wl_surface.frame callback; overridden to drive the scheduler
+         *        without a compositor.
+         */
+        virtual void request_callback(wl_surface* surface);
+        void on_frame_done(uint32_t time);
+
+    private:
+
+        static void frame_done(void *data, wl_callback *callback, uint32_t time);
+
+        void schedule();
+        void run_draw();
+        uint64_t now() const;
+        uint64_t render_estimate() const;
+
+        /** @brief Time compositors typically latch before the presentation they target. */
+        static constexpr uint64_t COMPOSITOR_MARGIN_NS = 2'000'000;
+        static constexpr size_t RENDER_HISTORY = 16;
+        /** @brief Refresh interval assumed before presentation feedback reports one. */
+        static constexpr uint64_t DEFAULT_REFRESH_NS = 16'666'667;
+
+        DrawFunction draw;
+        const FrameTimeline& timeline;
+        clockid_t clock;
+        FramePacing pacing = FramePacing::FrameCallback;
+
+        WlCallbackPtr callback;
+        bool waiting = false;
+        WaiterList frame_waiters;
+        bool dirty = false;
+        bool suspended = false;
+        uint32_t last_frame_time = 0;
+
+        uint64_t deadline_ns = 0;
+        /** @brief The deadline backs up an outstanding callback rather than late latching. */
+        bool urgent = false;
+        uint64_t target_presentation_ns = 0;
+        std::array<uint64_t, RENDER_HISTORY> render_durations{};
+        size_t render_index = 0;
+    };
+
+} // namespace tobi_engine
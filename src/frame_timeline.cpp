@@ -0,0 +1,89 @@
+#include "frame_timeline.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tobi_engine
+{
+
+    namespace
+    {
+        constexpr double to_milliseconds(uint64_t nanoseconds) noexcept
+        {
+            return double(nanoseconds) / 1'000'000.0;
+        }
+    }
+
+    void FrameTimeline::record_presented(uint64_t latency_ns, uint64_t refresh_ns, uint64_t presentation_ns)
+    {
+        std::lock_guard lock(mutex);
+        latencies[next] = latency_ns;
+        next = (next + 1) % CAPACITY;
+        count = std::min(count + 1, CAPACITY);
+        ++presented;
+        // 0 means the output has no constant refresh rate; keep the last known one.
+        if (refresh_ns)
+            this->refresh_ns = refresh_ns;
+        last_presentation_ns = std::max(last_presentation_ns, presentation_ns);
+    }
+
+    void FrameTimeline::record_discarded()
+    {
+        std::lock_guard lock(mutex);
+        ++discarded;
+    }
+
+    auto FrameTimeline::latency_percentile(double percentile) const -> uint64_t
+    {
+        std::lock_guard lock(mutex);
+        return latency_percentile_locked(percentile);
+    }
+
+    auto FrameTimeline::latency_percentile_locked(double percentile) const -> uint64_t
+    {
+        if (count == 0)
+            return 0;
+
+        // Nearest-rank percentile over the recorded window.
+        std::vector<uint64_t> sorted(latencies.begin(), latencies.begin() + count);
+        auto rank = static_cast<size_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * count));
+        auto index = rank == 0 ? 0 : rank - 1;
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    }
+
+    auto FrameTimeline::predict_presentation(uint64_t earliest_ns) const -> uint64_t
+    {
+        std::lock_guard lock(mutex);
+        if (!last_presentation_ns || !refresh_ns)
+            return 0;
+        if (earliest_ns <= last_presentation_ns)
+            return last_presentation_ns + refresh_ns;
+
+        auto intervals = (earliest_ns - last_presentation_ns + refresh_ns - 1) / refresh_ns;
+        return last_presentation_ns + intervals * refresh_ns;
+    }
+
+    auto FrameTimeline::get_refresh_ns() const -> uint64_t
+    {
+        std::lock_guard lock(mutex);
+        return refresh_ns;
+    }
+
+    auto FrameTimeline::get_statistics() const -> FrameStatistics
+    {
+        std::lock_guard lock(mutex);
+
+        FrameStatistics statistics;
+        statistics.presented = presented;
+        statistics.discarded = discarded;
+        statistics.refresh_interval_ms = to_milliseconds(refresh_ns);
+        statistics.latency_p50_ms = to_milliseconds(latency_percentile_locked(50.0));
+        statistics.latency_p90_ms = to_milliseconds(latency_percentile_locked(90.0));
+        statistics.latency_p99_ms = to_milliseconds(latency_percentile_locked(99.0));
+        statistics.latency_max_ms = to_milliseconds(latency_percentile_locked(100.0));
+        return statistics;
+    }
+
+} // namespace tobi_engine
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "window.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace tobi_engine
+{
+
+    /**
+     * @class FrameTimeline
+     * @brief Ring buffer of presentation feedback for one window.
+     *
+     * Keeps the commit-to-present latency of the last CAPACITY presented frames, the
+     * most recent refresh interval and running presented/discarded counts. Recording
+     * happens on the thread dispatching the window while statistics may be read from
+     * any thread, so access is serialized.
+     */
+    class FrameTimeline
+    {
+    public:
+
+        static constexpr size_t CAPACITY = 256;
+
+        /**
+         * @param presentation_ns Time the frame turned into light, in the presentation clock.
+         */
+        void record_presented(uint64_t latency_ns, uint64_t refresh_ns, uint64_t presentation_ns);
+        void record_discarded();
+
+        /**
+         * @brief Latency below which the given share of the recorded frames fall.
+         * @param percentile In the range [0, 100].
+         * @return Latency in nanoseconds, 0 if nothing was recorded yet.
+         */
+        auto latency_percentile(double percentile) const -> uint64_t;
+
+        auto get_statistics() const -> FrameStatistics;
+
+        /**
+         * @brief Predict the first presentation at or after earliest_ns by extrapolating
+         *        the last presentation with the refresh interval.
+         * @return Time in the presentation clock, 0 while no prediction is possible.
+         */
+        auto predict_presentation(uint64_t earliest_ns) const -> uint64_t;
+
+        /**
+         * @brief Most recently reported refresh interval, 0 while unknown.
+         */
+        auto get_refresh_ns() const -> uint64_t;
+
+    private:
+
+        auto latency_percentile_locked(double percentile) const -> uint64_t;
+
+        mutable std::mutex mutex;
+        std::array<uint64_t, CAPACITY> latencies{};
+        size_t next = 0;
+        size_t count = 0;
+        uint64_t presented = 0;
+        uint64_t discarded = 0;
+        uint64_t refresh_ns = 0;
+        uint64_t last_presentation_ns = 0;
+    };
+
+} // namespace tobi_engine
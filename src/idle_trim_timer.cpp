@@ -0,0 +1,33 @@
+#include "idle_trim_timer.hpp"
+
+namespace tobi_engine
+{
+
+    IdleTrimTimer::IdleTrimTimer(uint32_t timeout_ms, Clock::time_point now)
+        :   timeout_ms(timeout_ms),
+            last_repaint(now)
+    {
+    }
+
+    void IdleTrimTimer::on_commit(bool repainted, Clock::time_point now)
+    {
+        if (!repainted)
+            return;
+
+        last_repaint = now;
+        trimmed = false;
+    }
+
+    auto IdleTrimTimer::get_timeout_ms(Clock::time_point now) const -> int
+    {
+        if (trimmed || !timeout_ms)
+            return -1;
+
+        // Hidden windows get no frame callbacks, so they stop drawing and end up here too.
+        auto idle = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_repaint);
+        if (idle.count() >= timeout_ms)
+            return 0;
+        return static_cast<int>(timeout_ms - idle.count());
+    }
+
+} // namespace tobi_engine
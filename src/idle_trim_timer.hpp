@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace tobi_engine
+{
+
+    /**
+     * @class IdleTrimTimer
+     * @brief Decides when a window has been idle long enough to release its pixel memory.
+     *
+     * Only commits that repainted a buffer count as activity. A suspended window still
+     * commits to ack configures, and those must neither undo a trim nor restart the timer,
+     * or a window that is never shown would keep its memory forever.
+     *
+     * The timer belongs to the thread dispatching the window; is_trimmed() may also be
+     * read from the main loop.
+     */
+    class IdleTrimTimer
+    {
+    public:
+
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @param timeout_ms Idle time after which the window is trimmed, 0 to never trim.
+         */
+        explicit IdleTrimTimer(uint32_t timeout_ms, Clock::time_point now = Clock::now());
+
+        /**
+         * @brief Record a commit of the window.
+         * @param repainted Whether any surface painted or attached a buffer with it.
+         */
+        void on_commit(bool repainted, Clock::time_point now = Clock::now());
+
+        void mark_trimmed() { trimmed = true; }
+        bool is_trimmed() const { return trimmed; }
+
+        /**
+         * @brief Milliseconds until the window should be trimmed, 0 if it is due, -1 if it
+         *        is trimmed already or trimming is disabled.
+         */
+        auto get_timeout_ms(Clock::time_point now = Clock::now()) const -> int;
+
+    private:
+
+        uint32_t timeout_ms;
+        Clock::time_point last_repaint;
+        std::atomic<bool> trimmed = false;
+    };
+
+} // namespace tobi_engine
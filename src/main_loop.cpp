@@ -0,0 +1,53 @@
+#include "main_loop.hpp"
+
+#include "utils/logger.hpp"
+
+namespace tobi_engine
+{
+
+    MainLoop::MainLoop(WindowManager& window_manager)
+        : window_manager(window_manager)
+    {
+        LOG_DEBUG("MainLoop initialized");
+    }
+
+    bool MainLoop::run_once(int timeout_ms)
+    {
+        if (!running)
+            return false;
+
+        if (!window_manager.dispatch(timeout_ms))
+        {
+            LOG_ERROR("Lost connection to the compositor");
+            running = false;
+            return false;
+        }
+
+        window_manager.update();
+
+        if (update_callback)
+            update_callback();
+
+        if (window_manager.should_close())
+            running = false;
+
+        return running;
+    }
+
+    void MainLoop::run(int timeout_ms)
+    {
+        while (run_once(timeout_ms))
+            ;
+    }
+
+    void MainLoop::stop()
+    {
+        running = false;
+    }
+
+    void MainLoop::set_update_callback(std::function<void()> callback)
+    {
+        update_callback = std::move(callback);
+    }
+
+} // namespace tobi_engine
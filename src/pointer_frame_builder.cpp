@@ -0,0 +1,84 @@
+#include "pointer_frame_builder.hpp"
+
+namespace tobi_engine
+{
+
+    void PointerFrameBuilder::enter(double x, double y)
+    {
+        pending.moved = true;
+        pending.x = x;
+        pending.y = y;
+        end_event();
+    }
+
+    void PointerFrameBuilder::motion(uint32_t time, double x, double y)
+    {
+        pending.time = time;
+        pending.moved = true;
+        pending.x = x;
+        pending.y = y;
+        end_event();
+    }
+
+    void PointerFrameBuilder::button(uint32_t time, uint32_t button, uint32_t state)
+    {
+        if (pending.button_count == PointerFrame::MAX_BUTTONS)
+            flush();
+
+        pending.time = time;
+        pending.buttons[pending.button_count++] = { button, state };
+        end_event();
+    }
+
+    void PointerFrameBuilder::axis(uint32_t time, uint32_t axis, double value)
+    {
+        if (axis < pending.axis.size())
+        {
+            pending.time = time;
+            pending.scrolled = true;
+            pending.axis[axis] += value;
+        }
+        end_event();
+    }
+
+    void PointerFrameBuilder::axis_source(uint32_t source)
+    {
+        pending.axis_source = source;
+    }
+
+    void PointerFrameBuilder::axis_stop(uint32_t time, uint32_t axis)
+    {
+        if (axis < pending.axis_stop.size())
+        {
+            pending.time = time;
+            pending.scrolled = true;
+            pending.axis_stop[axis] = true;
+        }
+    }
+
+    void PointerFrameBuilder::axis_value120(uint32_t axis, int32_t value120)
+    {
+        if (axis < pending.axis_value120.size())
+            pending.axis_value120[axis] += value120;
+    }
+
+    void PointerFrameBuilder::axis_relative_direction(uint32_t axis, bool inverted)
+    {
+        if (axis < pending.axis_inverted.size())
+            pending.axis_inverted[axis] = inverted;
+    }
+
+    void PointerFrameBuilder::flush()
+    {
+        if (window && !pending.empty())
+            window->on_pointer_frame(pending);
+        pending = {};
+    }
+
+    void PointerFrameBuilder::end_event()
+    {
+        if (!frame_events)
+            flush();
+    }
+
+} // namespace tobi_engine
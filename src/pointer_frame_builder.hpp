@@ -0,0 +1,57 @@
+#pragma once
+
+#include "window.hpp"
+
+#include <cstdint>
+
+namespace tobi_engine
+{
+
+    /**
+     * @class PointerFrameBuilder
+     * @brief Gathers wl_pointer events into the PointerFrame handed to the window under the pointer.
+     *
+     * Motion, button and axis events arrive at the mouse's polling rate, so they only
+     * update the pending frame; the window hears about it once per wl_pointer.frame.
+     * Pointers without frame events (seat before v5) deliver every event as its own frame.
+     */
+    class PointerFrameBuilder
+    {
+    public:
+
+        /**
+         * @brief Select the window that receives the frames, nullptr for none.
+         * The caller flushes first if the pending frame belongs to the previous window.
+         */
+        void set_window(Window* window) { this->window = window; }
+        void set_frame_events(bool enabled) { frame_events = enabled; }
+
+        void enter(double x, double y);
+        void motion(uint32_t time, double x, double y);
+        void button(uint32_t time, uint32_t button, uint32_t state);
+        void axis(uint32_t time, uint32_t axis, double value);
+        void axis_source(uint32_t source);
+        void axis_stop(uint32_t time, uint32_t axis);
+        void axis_value120(uint32_t axis, int32_t value120);
+        void axis_relative_direction(uint32_t axis, bool inverted);
+
+        /**
+         * @brief Hand the pending frame to the window and start a new one.
+         */
+        void flush();
+
+        /**
+         * @brief Drop the pending frame, e.g. when the pointer goes away.
+         */
+        void reset() { pending = {}; }
+
+    private:
+
+        void end_event();
+
+        Window* window = nullptr;
+        bool frame_events = false;
+        PointerFrame pending;
+    };
+
+} // namespace tobi_engine
@@ -0,0 +1,133 @@
+#include "shm_block_allocator.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace tobi_engine
+{
+
+    auto ShmBlockAllocator::allocate(size_t size) -> ShmBlock
+    {
+        size = size_class(size);
+
+        if (auto bin = recycled_blocks.find(size); bin != recycled_blocks.end() && !bin->second.empty())
+        {
+            auto offset = bin->second.back();
+            bin->second.pop_back();
+            recycled_bytes -= size;
+            return { offset, size };
+        }
+
+        auto find_fit = [this, size]()
+        {
+            return std::find_if(free_blocks.begin(), free_blocks.end(),
+                [size](const auto& block) { return block.second >= size; });
+        };
+        auto fit = find_fit();
+
+        // Blocks of other size classes may coalesce into a fit before the caller grows.
+        if (fit == free_blocks.end() && recycled_bytes)
+        {
+            flush_recycled();
+            fit = find_fit();
+        }
+
+        if (fit == free_blocks.end())
+            return {};
+
+        auto offset = fit->first;
+        if (fit->second == size)
+        {
+            free_blocks.erase(fit);
+        }
+        else
+        {
+            // Reusing the node for the remainder keeps this free of allocations.
+            auto node = free_blocks.extract(fit);
+            node.key() += size;
+            node.mapped() -= size;
+            free_blocks.insert(std::move(node));
+        }
+
+        return { offset, size };
+    }
+
+    void ShmBlockAllocator::free(const ShmBlock& block) noexcept
+    {
+        if (!block)
+            return;
+
+        try
+        {
+            auto& bin = recycled_blocks[block.size];
+            if (bin.size() < MAX_RECYCLED_PER_CLASS && recycled_bytes + block.size <= MAX_RECYCLED_BYTES)
+            {
+                // Reserved once per class, so binning never allocates again.
+                bin.reserve(MAX_RECYCLED_PER_CLASS);
+                bin.push_back(block.offset);
+                recycled_bytes += block.size;
+                return;
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+        }
+
+        insert_free(block.offset, block.size);
+    }
+
+    void ShmBlockAllocator::flush_recycled() noexcept
+    {
+        for (auto& [size, offsets] : recycled_blocks)
+        {
+            for (auto offset : offsets)
+                insert_free(offset, size);
+            offsets.clear();
+        }
+        recycled_bytes = 0;
+    }
+
+    void ShmBlockAllocator::insert_free(size_t offset, size_t size) noexcept
+    {
+        auto next = free_blocks.lower_bound(offset);
+        const bool merge_next = next != free_blocks.end() && offset + size == next->first;
+
+        // Merge with the preceding block, and through it with the following one.
+        if (next != free_blocks.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                previous->second += size;
+                if (merge_next)
+                {
+                    previous->second += next->second;
+                    free_blocks.erase(next);
+                }
+                return;
+            }
+        }
+
+        // Merge with the following block by moving its node down to the new start.
+        if (merge_next)
+        {
+            auto node = free_blocks.extract(next);
+            node.key() = offset;
+            node.mapped() += size;
+            free_blocks.insert(std::move(node));
+            return;
+        }
+
+        try
+        {
+            free_blocks.emplace_hint(next, offset, size);
+        }
+        catch (const std::bad_alloc&)
+        {
+            // The range stays unused for the lifetime of the arena, which beats terminating.
+        }
+    }
+
+} // namespace tobi_engine
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace tobi_engine
+{
+
+    /**
+     * @brief A region carved out of a WaylandShmArena.
+     */
+    struct ShmBlock
+    {
+        size_t offset = 0;
+        size_t size = 0;
+
+        explicit operator bool() const noexcept { return size != 0; }
+    };
+
+    /**
+     * @class ShmBlockAllocator
+     * @brief Offset bookkeeping of a WaylandShmArena, without any memory of its own.
+     *
+     * Requests are rounded up to geometric size classes and freed blocks are kept in
+     * per-class bins for reuse, falling back to a first-fit free list that coalesces
+     * on free. The bins are bounded per class and in total; blocks beyond either limit
+     * go straight to the free list.
+     *
+     * Freeing never throws: when the bookkeeping itself cannot allocate, a block is
+     * moved to the free list instead of a bin, and as a last resort dropped, leaving
+     * its range unused rather than terminating. Not thread-safe; the arena locks.
+     */
+    class ShmBlockAllocator
+    {
+    public:
+
+        /**
+         * @brief Take a block of size_class(size) bytes from a bin or the free list.
+         * Flushes the bins before giving up, so blocks of other classes can coalesce.
+         * @return An empty block if nothing fits; the caller grows the range with add().
+         */
+        auto allocate(size_t size) -> ShmBlock;
+
+        /**
+         * @brief Return a block to its size class bin, or to the free list when the bin or
+         *        the bytes held by all bins are at their limit.
+         */
+        void free(const ShmBlock& block) noexcept;
+
+        /**
+         * @brief Make a new range available, e.g. after the arena grew.
+         */
+        void add(size_t offset, size_t size) noexcept { insert_free(offset, size); }
+
+        /**
+         * @brief Move every binned block to the free list, where it coalesces with its neighbours.
+         */
+        void flush_recycled() noexcept;
+
+        /**
+         * @brief Free ranges keyed by offset, mapping to their size; binned blocks are not included.
+         */
+        auto get_free_blocks() const noexcept -> const std::map<size_t, size_t>& { return free_blocks; }
+        auto get_recycled_bytes() const noexcept -> size_t { return recycled_bytes; }
+
+        /**
+         * @brief Round a size up to its class: four steps per power of two, page aligned.
+         */
+        static constexpr auto size_class(size_t size) noexcept -> size_t
+        {
+            if (size <= ALIGNMENT)
+                return ALIGNMENT;
+
+            size_t power = ALIGNMENT;
+            while (power * 2 < size)
+                power *= 2;
+
+            auto step = power / 4;
+            auto rounded = (size + step - 1) / step * step;
+            return (rounded + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        }
+
+        static constexpr size_t ALIGNMENT = 4096;
+        static constexpr size_t MAX_RECYCLED_PER_CLASS = 4;
+        static constexpr size_t MAX_RECYCLED_BYTES = 32 * 1024 * 1024;
+
+    private:
+
+        void insert_free(size_t offset, size_t size) noexcept;
+
+        std::map<size_t, size_t> free_blocks;
+
+        /**
+         * @brief Recently freed blocks keyed by size class, holding their offsets.
+         */
+        std::unordered_map<size_t, std::vector<size_t>> recycled_blocks;
+        size_t recycled_bytes = 0;
+    };
+
+} // namespace tobi_engine
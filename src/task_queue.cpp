@@ -0,0 +1,93 @@
+#include "task_queue.hpp"
+
+#include "utils/logger.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace tobi_engine
+{
+
+    TaskQueue::TaskQueue(int wake_fd)
+        :   head(new Node),
+            tail(head.load()),
+            wake_fd(wake_fd),
+            owns_fd(wake_fd < 0)
+    {
+        if (owns_fd)
+        {
+            this->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (this->wake_fd == -1)
+            {
+                delete tail;
+                LOG_ERROR("Failed to create task queue eventfd");
+                throw std::runtime_error("Failed to create task queue eventfd");
+            }
+        }
+    }
+
+    TaskQueue::~TaskQueue()
+    {
+        while (tail)
+        {
+            auto next = tail->next.load();
+            delete tail;
+            tail = next;
+        }
+        if (owns_fd)
+            close(wake_fd);
+    }
+
+    void TaskQueue::post(Task task)
+    {
+        auto node = new Node;
+        node->task = std::move(task);
+
+        // Between the exchange and the link the consumer cannot see the node yet; it is
+        // woken up again below once the link is in place.
+        auto previous = head.exchange(node);
+        previous->next.store(node);
+
+        if (!signalled.exchange(true))
+        {
+            uint64_t one = 1;
+            if (write(wake_fd, &one, sizeof(one)) != sizeof(one))
+                LOG_WARNING("Failed to signal task queue eventfd");
+        }
+    }
+
+    size_t TaskQueue::run()
+    {
+        // Re-arm the wakeup before draining, so a task posted from here on either gets
+        // drained below or writes the eventfd again. A shared eventfd is only drained by
+        // the queue that owns it, which has to run before the queues sharing it.
+        if (owns_fd)
+        {
+            uint64_t count = 0;
+            while (read(wake_fd, &count, sizeof(count)) > 0)
+                ;
+        }
+        signalled.store(false);
+
+        // Tasks posted by the tasks themselves wait for the next run.
+        const auto last = head.load();
+        size_t ran = 0;
+        while (tail != last)
+        {
+            auto next = tail->next.load();
+            if (!next)
+                break;
+
+            auto task = std::move(next->task);
+            delete tail;
+            tail = next;
+
+            task();
+            ++ran;
+        }
+        return ran;
+    }
+
+} // namespace tobi_engine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+namespace tobi_engine
+{
+
+    /**
+     * @class TaskQueue
+     * @brief Lock-free multi-producer, single-consumer queue of tasks with an eventfd wakeup.
+     *
+     * Any thread may post() a task; only the thread that owns the queue runs them. The
+     * queue is an intrusive linked list where producers only exchange the head, so
+     * posting never takes a lock. The eventfd is written once per batch, when the first
+     * task arrives after the consumer last drained the queue, so it can be added to a
+     * poll or epoll set to wake the consumer right away.
+     *
+     * Several queues may share one eventfd. Only the queue that created it drains it, so
+     * the consumer runs that queue first and then every queue sharing its eventfd.
+     */
+    class TaskQueue
+    {
+    public:
+
+        using Task = std::function<void()>;
+
+        /**
+         * @param wake_fd eventfd shared with other queues, or -1 to create one owned by the queue.
+         * @throws std::runtime_error if the eventfd cannot be created.
+         */
+        explicit TaskQueue(int wake_fd = -1);
+        TaskQueue(const TaskQueue&) = delete;
+        TaskQueue& operator=(const TaskQueue&) = delete;
+        ~TaskQueue();
+
+        /**
+         * @brief Queue a task and wake the consumer. Safe to call from any thread.
+         */
+        void post(Task task);
+
+        /**
+         * @brief Run every task posted so far. Consumer thread only.
+         * @return The number of tasks that ran.
+         */
+        size_t run();
+
+        /**
+         * @brief File descriptor that becomes readable when tasks were posted.
+         */
+        int get_fd() const noexcept { return wake_fd; }
+
+    private:
+
+        struct Node
+        {
+            std::atomic<Node*> next = nullptr;
+            Task task;
+        };
+
+        /** @brief Most recently posted node, exchanged by the producers. */
+        std::atomic<Node*> head;
+        /** @brief Node before the oldest task; owned by the consumer. */
+        Node* tail;
+
+        std::atomic<bool> signalled = false;
+        int wake_fd;
+        bool owns_fd;
+    };
+
+} // namespace tobi_engine
@@ -0,0 +1,480 @@
+#include "pixel_kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define TOBI_PIXEL_KERNELS_X86 1
+#elif defined(__aarch64__)
+    #include <arm_neon.h>
+    #define TOBI_PIXEL_KERNELS_NEON 1
+#endif
+
+namespace tobi_engine
+{
+
+    namespace
+    {
+        // Above this size fills and copies bypass the cache; the buffer is handed to the
+        // compositor afterwards, so pulling it into our caches only evicts useful data.
+        constexpr size_t STREAMING_THRESHOLD = 256 * 1024 / sizeof(uint32_t);
+
+        constexpr uint32_t div255(uint32_t value)
+        {
+            value += 128;
+            return (value + (value >> 8)) >> 8;
+        }
+
+        // ---------------------------------------------------------------- scalar
+
+        void fill_scalar(uint32_t* destination, size_t count, uint32_t colour)
+        {
+            std::fill(destination, destination + count, colour);
+        }
+
+        void copy_scalar(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            std::memcpy(destination, source, count * sizeof(uint32_t));
+        }
+
+        void blend_over_scalar(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto src = source[i];
+                auto dst = destination[i];
+                auto inverse_alpha = 255 - (src >> 24);
+
+                uint32_t result = 0;
+                for (uint32_t shift = 0; shift < 32; shift += 8)
+                {
+                    auto channel = ((src >> shift) & 0xFF) + div255(((dst >> shift) & 0xFF) * inverse_alpha);
+                    result |= std::min<uint32_t>(channel, 255) << shift;
+                }
+                destination[i] = result;
+            }
+        }
+
+        constexpr PixelKernels SCALAR_KERNELS
+        {
+            "scalar",
+            &fill_scalar,
+            &copy_scalar,
+            &blend_over_scalar
+        };
+
+#if defined(TOBI_PIXEL_KERNELS_X86)
+
+        // ---------------------------------------------------------------- SSE2
+
+        __attribute__((target("sse2")))
+        void fill_sse2(uint32_t* destination, size_t count, uint32_t colour)
+        {
+            auto value = _mm_set1_epi32(static_cast<int>(colour));
+            auto streaming = count >= STREAMING_THRESHOLD;
+
+            for (; count && (reinterpret_cast<uintptr_t>(destination) & 15); --count)
+                *destination++ = colour;
+
+            size_t i = 0;
+            if (streaming)
+            {
+                for (; i + 4 <= count; i += 4)
+                    _mm_stream_si128(reinterpret_cast<__m128i*>(destination + i), value);
+                _mm_sfence();
+            }
+            else
+            {
+                for (; i + 4 <= count; i += 4)
+                    _mm_store_si128(reinterpret_cast<__m128i*>(destination + i), value);
+            }
+            for (; i < count; ++i)
+                destination[i] = colour;
+        }
+
+        __attribute__((target("sse2")))
+        void copy_sse2(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            if (count < STREAMING_THRESHOLD)
+            {
+                std::memcpy(destination, source, count * sizeof(uint32_t));
+                return;
+            }
+
+            for (; count && (reinterpret_cast<uintptr_t>(destination) & 15); --count)
+                *destination++ = *source++;
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+                _mm_stream_si128(reinterpret_cast<__m128i*>(destination + i),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+            _mm_sfence();
+            for (; i < count; ++i)
+                destination[i] = source[i];
+        }
+
+        // channels * alpha / 255 on 16-bit lanes, rounded like div255()
+        __attribute__((target("sse2")))
+        inline __m128i scale_sse2(__m128i channels, __m128i alpha)
+        {
+            auto product = _mm_add_epi16(_mm_mullo_epi16(channels, alpha), _mm_set1_epi16(128));
+            return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+        }
+
+        __attribute__((target("sse2")))
+        inline __m128i blend_4_sse2(__m128i src, __m128i dst)
+        {
+            const auto zero = _mm_setzero_si128();
+
+            // 255 - alpha, replicated into both 16-bit halves of every pixel
+            auto inverse_alpha = _mm_sub_epi32(_mm_set1_epi32(255), _mm_srli_epi32(src, 24));
+            inverse_alpha = _mm_or_si128(inverse_alpha, _mm_slli_epi32(inverse_alpha, 16));
+
+            auto low = scale_sse2(_mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi32(inverse_alpha, inverse_alpha));
+            auto high = scale_sse2(_mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi32(inverse_alpha, inverse_alpha));
+
+            return _mm_adds_epu8(src, _mm_packus_epi16(low, high));
+        }
+
+        __attribute__((target("sse2")))
+        void blend_over_sse2(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                auto src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                auto dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), blend_4_sse2(src, dst));
+            }
+            blend_over_scalar(destination + i, source + i, count - i);
+        }
+
+        constexpr PixelKernels SSE2_KERNELS
+        {
+            "sse2",
+            &fill_sse2,
+            &copy_sse2,
+            &blend_over_sse2
+        };
+
+        // ---------------------------------------------------------------- AVX2
+
+        __attribute__((target("avx2")))
+        void fill_avx2(uint32_t* destination, size_t count, uint32_t colour)
+        {
+            auto value = _mm256_set1_epi32(static_cast<int>(colour));
+            auto streaming = count >= STREAMING_THRESHOLD;
+
+            for (; count && (reinterpret_cast<uintptr_t>(destination) & 31); --count)
+                *destination++ = colour;
+
+            size_t i = 0;
+            if (streaming)
+            {
+                for (; i + 8 <= count; i += 8)
+                    _mm256_stream_si256(reinterpret_cast<__m256i*>(destination + i), value);
+                _mm_sfence();
+            }
+            else
+            {
+                for (; i + 8 <= count; i += 8)
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(destination + i), value);
+            }
+            for (; i < count; ++i)
+                destination[i] = colour;
+        }
+
+        __attribute__((target("avx2")))
+        void copy_avx2(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            if (count < STREAMING_THRESHOLD)
+            {
+                std::memcpy(destination, source, count * sizeof(uint32_t));
+                return;
+            }
+
+            for (; count && (reinterpret_cast<uintptr_t>(destination) & 31); --count)
+                *destination++ = *source++;
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(destination + i),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i)));
+            _mm_sfence();
+            for (; i < count; ++i)
+                destination[i] = source[i];
+        }
+
+        __attribute__((target("avx2")))
+        inline __m256i scale_avx2(__m256i channels, __m256i alpha)
+        {
+            auto product = _mm256_add_epi16(_mm256_mullo_epi16(channels, alpha), _mm256_set1_epi16(128));
+            return _mm256_srli_epi16(_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+        }
+
+        __attribute__((target("avx2")))
+        void blend_over_avx2(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            const auto zero = _mm256_setzero_si256();
+            const auto opaque = _mm256_set1_epi32(255);
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                auto src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                auto dst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + i));
+
+                auto inverse_alpha = _mm256_sub_epi32(opaque, _mm256_srli_epi32(src, 24));
+                inverse_alpha = _mm256_or_si256(inverse_alpha, _mm256_slli_epi32(inverse_alpha, 16));
+
+                // Unpacks and packs work per 128-bit lane, so pixel order is preserved.
+                auto low = scale_avx2(_mm256_unpacklo_epi8(dst, zero), _mm256_unpacklo_epi32(inverse_alpha, inverse_alpha));
+                auto high = scale_avx2(_mm256_unpackhi_epi8(dst, zero), _mm256_unpackhi_epi32(inverse_alpha, inverse_alpha));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i),
+                                    _mm256_adds_epu8(src, _mm256_packus_epi16(low, high)));
+            }
+            blend_over_sse2(destination + i, source + i, count - i);
+        }
+
+        constexpr PixelKernels AVX2_KERNELS
+        {
+            "avx2",
+            &fill_avx2,
+            &copy_avx2,
+            &blend_over_avx2
+        };
+
+        // ---------------------------------------------------------------- AVX-512
+
+        __attribute__((target("avx512f,avx512bw")))
+        void fill_avx512(uint32_t* destination, size_t count, uint32_t colour)
+        {
+            auto value = _mm512_set1_epi32(static_cast<int>(colour));
+            auto streaming = count >= STREAMING_THRESHOLD;
+
+            for (; count && (reinterpret_cast<uintptr_t>(destination) & 63); --count)
+                *destination++ = colour;
+
+            size_t i = 0;
+            if (streaming)
+            {
+                for (; i + 16 <= count; i += 16)
+                    _mm512_stream_si512(reinterpret_cast<__m512i*>(destination + i), value);
+                _mm_sfence();
+            }
+            else
+            {
+                for (; i + 16 <= count; i += 16)
+                    _mm512_store_si512(reinterpret_cast<__m512i*>(destination + i), value);
+            }
+            if (i < count)
+            {
+                auto mask = static_cast<__mmask16>((1u << (count - i)) - 1);
+                _mm512_mask_storeu_epi32(destination + i, mask, value);
+            }
+        }
+
+        __attribute__((target("avx512f,avx512bw")))
+        void copy_avx512(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            if (count < STREAMING_THRESHOLD)
+            {
+                std::memcpy(destination, source, count * sizeof(uint32_t));
+                return;
+            }
+
+            for (; count && (reinterpret_cast<uintptr_t>(destination) & 63); --count)
+                *destination++ = *source++;
+
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16)
+                _mm512_stream_si512(reinterpret_cast<__m512i*>(destination + i),
+                                    _mm512_loadu_si512(source + i));
+            _mm_sfence();
+            for (; i < count; ++i)
+                destination[i] = source[i];
+        }
+
+        __attribute__((target("avx512f,avx512bw")))
+        inline __m512i scale_avx512(__m512i channels, __m512i alpha)
+        {
+            auto product = _mm512_add_epi16(_mm512_mullo_epi16(channels, alpha), _mm512_set1_epi16(128));
+            return _mm512_srli_epi16(_mm512_add_epi16(product, _mm512_srli_epi16(product, 8)), 8);
+        }
+
+        __attribute__((target("avx512f,avx512bw")))
+        void blend_over_avx512(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            const auto zero = _mm512_setzero_si512();
+            const auto opaque = _mm512_set1_epi32(255);
+
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16)
+            {
+                auto src = _mm512_loadu_si512(source + i);
+                auto dst = _mm512_loadu_si512(destination + i);
+
+                auto inverse_alpha = _mm512_sub_epi32(opaque, _mm512_srli_epi32(src, 24));
+                inverse_alpha = _mm512_or_si512(inverse_alpha, _mm512_slli_epi32(inverse_alpha, 16));
+
+                auto low = scale_avx512(_mm512_unpacklo_epi8(dst, zero), _mm512_unpacklo_epi32(inverse_alpha, inverse_alpha));
+                auto high = scale_avx512(_mm512_unpackhi_epi8(dst, zero), _mm512_unpackhi_epi32(inverse_alpha, inverse_alpha));
+
+                _mm512_storeu_si512(destination + i, _mm512_adds_epu8(src, _mm512_packus_epi16(low, high)));
+            }
+            blend_over_avx2(destination + i, source + i, count - i);
+        }
+
+        constexpr PixelKernels AVX512_KERNELS
+        {
+            "avx512",
+            &fill_avx512,
+            &copy_avx512,
+            &blend_over_avx512
+        };
+
+#elif defined(TOBI_PIXEL_KERNELS_NEON)
+
+        // ---------------------------------------------------------------- NEON
+
+        void fill_neon(uint32_t* destination, size_t count, uint32_t colour)
+        {
+            auto value = vdupq_n_u32(colour);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+                vst1q_u32(destination + i, value);
+            for (; i < count; ++i)
+                destination[i] = colour;
+        }
+
+        void copy_neon(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+                vst1q_u32(destination + i, vld1q_u32(source + i));
+            for (; i < count; ++i)
+                destination[i] = source[i];
+        }
+
+        inline uint8x8_t scale_neon(uint8x8_t channels, uint8x8_t alpha)
+        {
+            auto product = vaddq_u16(vmull_u8(channels, alpha), vdupq_n_u16(128));
+            return vshrn_n_u16(vaddq_u16(product, vshrq_n_u16(product, 8)), 8);
+        }
+
+        void blend_over_neon(uint32_t* destination, const uint32_t* source, size_t count)
+        {
+            static constexpr uint8_t ALPHA_INDICES[16] = { 3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15 };
+            const auto alpha_indices = vld1q_u8(ALPHA_INDICES);
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                auto src = vreinterpretq_u8_u32(vld1q_u32(source + i));
+                auto dst = vreinterpretq_u8_u32(vld1q_u32(destination + i));
+                auto inverse_alpha = vmvnq_u8(vqtbl1q_u8(src, alpha_indices));
+
+                auto scaled = vcombine_u8(scale_neon(vget_low_u8(dst), vget_low_u8(inverse_alpha)),
+                                          scale_neon(vget_high_u8(dst), vget_high_u8(inverse_alpha)));
+
+                vst1q_u32(destination + i, vreinterpretq_u32_u8(vqaddq_u8(src, scaled)));
+            }
+            blend_over_scalar(destination + i, source + i, count - i);
+        }
+
+        constexpr PixelKernels NEON_KERNELS
+        {
+            "neon",
+            &fill_neon,
+            &copy_neon,
+            &blend_over_neon
+        };
+
+#endif
+
+        struct KernelRegistry
+        {
+            std::array<const PixelKernels*, 4> kernels{};
+            size_t count = 0;
+
+            KernelRegistry()
+            {
+                kernels[count++] = &SCALAR_KERNELS;
+#if defined(TOBI_PIXEL_KERNELS_X86)
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("sse2"))
+                    kernels[count++] = &SSE2_KERNELS;
+                if (__builtin_cpu_supports("avx2"))
+                    kernels[count++] = &AVX2_KERNELS;
+                if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+                    kernels[count++] = &AVX512_KERNELS;
+#elif defined(TOBI_PIXEL_KERNELS_NEON)
+                kernels[count++] = &NEON_KERNELS;
+#endif
+            }
+        };
+
+        auto registry() noexcept -> const KernelRegistry&
+        {
+            static const KernelRegistry kernel_registry;
+            return kernel_registry;
+        }
+    }
+
+    auto PixelKernels::get() noexcept -> const PixelKernels&
+    {
+        static const PixelKernels& best = *registry().kernels[registry().count - 1];
+        return best;
+    }
+
+    auto PixelKernels::scalar() noexcept -> const PixelKernels&
+    {
+        return SCALAR_KERNELS;
+    }
+
+    auto PixelKernels::available() noexcept -> std::span<const PixelKernels* const>
+    {
+        return { registry().kernels.data(), registry().count };
+    }
+
+    void fill_rect(uint32_t* pixels, uint32_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t colour)
+    {
+        const auto& kernels = PixelKernels::get();
+
+        // Full-width rectangles are contiguous and can go through a single call.
+        if (x == 0 && width == stride)
+        {
+            kernels.fill(pixels + size_t(y) * stride, size_t(width) * height, colour);
+            return;
+        }
+
+        for (uint32_t row = y; row < y + height; ++row)
+            kernels.fill(pixels + size_t(row) * stride + x, width, colour);
+    }
+
+    void blit(uint32_t* destination, uint32_t destination_stride, const uint32_t* source, uint32_t source_stride, uint32_t width, uint32_t height)
+    {
+        const auto& kernels = PixelKernels::get();
+
+        if (width == destination_stride && width == source_stride)
+        {
+            kernels.copy(destination, source, size_t(width) * height);
+            return;
+        }
+
+        for (uint32_t row = 0; row < height; ++row)
+            kernels.copy(destination + size_t(row) * destination_stride, source + size_t(row) * source_stride, width);
+    }
+
+    void blend_over(uint32_t* destination, uint32_t destination_stride, const uint32_t* source, uint32_t source_stride, uint32_t width, uint32_t height)
+    {
+        const auto& kernels = PixelKernels::get();
+
+        for (uint32_t row = 0; row < height; ++row)
+            kernels.blend_over(destination + size_t(row) * destination_stride, source + size_t(row) * source_stride, width);
+    }
+
+} // namespace tobi_engine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace tobi_engine
+{
+
+    /**
+     * @brief Table of row kernels operating on 32-bit premultiplied ARGB pixels.
+     *
+     * One table exists per instruction set (scalar, SSE2, AVX2, AVX-512, NEON). The
+     * best table for the running CPU is picked once at startup; the scalar table is
+     * the reference implementation the others are tested against.
+     */
+    struct PixelKernels
+    {
+        using FillFn = void (*)(uint32_t* destination, size_t count, uint32_t colour);
+        using CopyFn = void (*)(uint32_t* destination, const uint32_t* source, size_t count);
+        using BlendFn = void (*)(uint32_t* destination, const uint32_t* source, size_t count);
+
+        const char* name;
+        /** @brief Set count pixels to colour. */
+        FillFn fill;
+        /** @brief Copy count pixels; the ranges must not overlap. */
+        CopyFn copy;
+        /** @brief Premultiplied source-over: dst = src + dst * (255 - src.a) / 255. */
+        BlendFn blend_over;
+
+        /**
+         * @brief Kernels selected for this CPU via CPUID (x86) or the build target (ARM).
+         */
+        static auto get() noexcept -> const PixelKernels&;
+        /**
+         * @brief Portable reference kernels.
+         */
+        static auto scalar() noexcept -> const PixelKernels&;
+        /**
+         * @brief Every kernel table the running CPU can execute, scalar first.
+         */
+        static auto available() noexcept -> std::span<const PixelKernels* const>;
+    };
+
+    /**
+     * @brief Fill a rectangle of a pixel buffer.
+     * @param stride Row pitch in pixels.
+     */
+    void fill_rect(uint32_t* pixels, uint32_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t colour);
+
+    /**
+     * @brief Copy a width x height block between two pixel buffers.
+     * @param destination_stride Row pitch of the destination in pixels.
+     * @param source_stride Row pitch of the source in pixels.
+     */
+    void blit(uint32_t* destination, uint32_t destination_stride, const uint32_t* source, uint32_t source_stride, uint32_t width, uint32_t height);
+
+    /**
+     * @brief Composite a width x height block of premultiplied pixels over a destination.
+     */
+    void blend_over(uint32_t* destination, uint32_t destination_stride, const uint32_t* source, uint32_t source_stride, uint32_t width, uint32_t height);
+
+} // namespace tobi_engine
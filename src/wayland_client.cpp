@@ -1,6 +1,7 @@
 #include "wayland_client.hpp"
 
 #include "utils/logger.hpp"
+#include "wayland_cursor.hpp"
 #include "wayland_input_manager.hpp"
 
 #include "wayland-xdg-shell-client-protocol.h"
@@ -12,9 +13,11 @@
 #include <wayland-util.h>
 #include <xkbcommon/xkbcommon.h>
 
+#include <cerrno>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <poll.h>
 #include <stdexcept>
 
 namespace tobi_engine
@@ -36,29 +39,142 @@ namespace tobi_engine
             LOG_ERROR("Failed to flush Wayland display");
             return false;
         }
-        if (!display->roundtrip())
+        return true;
+    }
+
+    auto WaylandClient::dispatch(int timeout_ms, wl_event_queue* queue, int wake_fd) -> bool
+    {
+        auto events = prepare_read(queue);
+        if (!events)
+            return false;
+
+        // A wakeup only interrupts the wait; the caller runs whatever was posted.
+        pollfd descriptors[] { { display->get_fd(), events, 0 }, { wake_fd, POLLIN, 0 } };
+        auto ready = poll(descriptors, wake_fd < 0 ? 1 : 2, timeout_ms);
+        if (ready < 0 && errno != EINTR)
+        {
+            display->cancel_read();
+            LOG_ERROR("Failed to poll Wayland display");
+            return false;
+        }
+        if (ready <= 0 || !(descriptors[0].revents & (POLLIN | POLLERR | POLLHUP)))
+        {
+            display->cancel_read();
+            return true;
+        }
+
+        return read_events(queue);
+    }
+
+    auto WaylandClient::get_fd() const -> int
+    {
+        return display->get_fd();
+    }
+
+    auto WaylandClient::prepare_read(wl_event_queue* queue) -> short
+    {
+        // Events already queued have to be dispatched before the socket may be read.
+        while (!display->prepare_read(queue))
+        {
+            if (!display->dispatch_pending(queue))
+            {
+                LOG_ERROR("Failed to dispatch Wayland events");
+                return 0;
+            }
+        }
+
+        // A full socket buffer is not an error, the rest is flushed once it drains.
+        short events = POLLIN;
+        if (!display->flush())
+        {
+            if (errno != EAGAIN)
+            {
+                display->cancel_read();
+                LOG_ERROR("Failed to flush Wayland display");
+                return 0;
+            }
+            events |= POLLOUT;
+        }
+        return events;
+    }
+
+    auto WaylandClient::read_events(wl_event_queue* queue) -> bool
+    {
+        if (!display->read_events() || !display->dispatch_pending(queue))
         {
-            LOG_ERROR("Failed to roundtrip Wayland display");
+            LOG_ERROR("Failed to dispatch Wayland events");
             return false;
         }
         return true;
     }
 
-    auto WaylandClient::update() -> bool
+    void WaylandClient::cancel_read()
     {
-        if (!display->dispatch())
+        display->cancel_read();
+    }
+
+    auto WaylandClient::dispatch_pending(wl_event_queue* queue) -> bool
+    {
+        if (!display->dispatch_pending(queue))
         {
-            LOG_ERROR("Failed to dispatch Wayland display");
+            LOG_ERROR("Failed to dispatch Wayland events");
             return false;
         }
         return true;
     }
 
-    void WaylandClient::clear()
+    auto WaylandClient::create_event_queue() -> WlEventQueuePtr
+    {
+        auto queue = display->create_queue();
+        if (!queue)
+        {
+            LOG_ERROR("Failed to create Wayland event queue");
+            throw std::runtime_error("Failed to create Wayland event queue");
+        }
+        return queue;
+    }
+
+    auto WaylandClient::sync(wl_event_queue* queue) -> SyncAwaiter
+    {
+        return { display->get(), queue };
+    }
+
+    void SyncAwaiter::await_suspend(std::coroutine_handle<> handle)
     {
-        display->dispatch_pending();
-        if (!display->roundtrip())
-            LOG_WARNING("Failed to roundtrip Wayland display");
+        static constexpr wl_callback_listener sync_listener
+        {
+            &SyncAwaiter::done
+        };
+
+        this->handle = handle;
+        if (queue)
+        {
+            auto wrapper = create_queue_wrapper(display, queue);
+            callback.reset(wl_display_sync(wrapper.get()));
+        }
+        else
+        {
+            callback.reset(wl_display_sync(display));
+        }
+        wl_callback_add_listener(callback.get(), &sync_listener, this);
+    }
+
+    void SyncAwaiter::done(void *data, wl_callback *callback, uint32_t serial)
+    {
+        // Resuming may finish the coroutine and free the awaiter with it.
+        auto self = static_cast<SyncAwaiter*>(data);
+        self->callback.reset();
+        self->handle.resume();
+    }
+
+    void WaylandClient::post(TaskQueue::Task task)
+    {
+        tasks.post(std::move(task));
+    }
+
+    void WaylandClient::run_tasks()
+    {
+        tasks.run();
     }
 
     void WaylandClient::initialize()
@@ -80,6 +196,30 @@ namespace tobi_engine
             LOG_ERROR("Wayland shell is not available");
             throw std::runtime_error("Failed to initialize Wayland Client");
         }
+
+        if (auto presentation = wayland_registry->get_presentation())
+        {
+            static constexpr wp_presentation_listener presentation_listener
+            {
+                &WaylandClient::presentation_clock_id
+            };
+            wp_presentation_add_listener(presentation, &presentation_listener, this);
+
+            // Windows take the clock when they are created, so wait for it.
+            if (!display->roundtrip())
+            {
+                LOG_ERROR("Failed to roundtrip Wayland display");
+                throw std::runtime_error("Failed to initialize Wayland Client");
+            }
+        }
+
+        shm_arena = std::make_unique<WaylandShmArena>(wayland_registry->get_shm());
+
+        // The first window needs the cursor theme; load it while that window is set up.
+        // Compositors drawing cursors by shape make the theme unnecessary.
+        cursor_themes = std::make_unique<CursorThemeCache>(wayland_registry->get_shm());
+        if (!has_cursor_shapes())
+            cursor_themes->prewarm(WaylandCursor::get_default_theme(), WaylandCursor::get_default_size(), 1);
     }
 
     void WaylandClient::shell_ping(void *data, xdg_wm_base *shell, uint32_t serial) 
@@ -95,6 +235,18 @@ namespace tobi_engine
     }
 
 
+    void WaylandClient::presentation_clock_id(void *data, wp_presentation *presentation, uint32_t clock_id)
+    {
+        LOG_DEBUG("presentation clock = {}", clock_id);
+        auto self = static_cast<WaylandClient*>(data);
+        self->presentation_clock = static_cast<clockid_t>(clock_id);
+    }
+
+    auto WaylandClient::get_display() -> wl_display* const
+    {
+        return display->get();
+    }
+
     auto WaylandClient::get_compositor() -> wl_compositor* const
     {
         return wayland_registry->get_compositor();
@@ -115,9 +267,68 @@ namespace tobi_engine
         return wayland_registry->get_shm();
     }
 
+    auto WaylandClient::get_single_pixel_buffer_manager() -> wp_single_pixel_buffer_manager_v1* const
+    {
+        return wayland_registry->get_single_pixel_buffer_manager();
+    }
+
+    auto WaylandClient::get_viewporter() -> wp_viewporter* const
+    {
+        return wayland_registry->get_viewporter();
+    }
+
+    auto WaylandClient::get_decoration_manager() -> zxdg_decoration_manager_v1* const
+    {
+        return wayland_registry->get_decoration_manager();
+    }
+
+    auto WaylandClient::get_presentation() -> wp_presentation* const
+    {
+        return wayland_registry->get_presentation();
+    }
+
+    auto WaylandClient::get_tearing_control_manager() -> wp_tearing_control_manager_v1* const
+    {
+        return wayland_registry->get_tearing_control_manager();
+    }
+
+#if defined(TOBI_HAS_FIFO_V1)
+    auto WaylandClient::get_fifo_manager() -> wp_fifo_manager_v1* const
+    {
+        return wayland_registry->get_fifo_manager();
+    }
+#endif
+
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+    auto WaylandClient::get_commit_timing_manager() -> wp_commit_timing_manager_v1* const
+    {
+        return wayland_registry->get_commit_timing_manager();
+    }
+#endif
+
+    auto WaylandClient::has_cursor_shapes() const -> bool
+    {
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+        return wayland_registry->get_cursor_shape_manager() != nullptr;
+#else
+        return false;
+#endif
+    }
+
     auto WaylandClient::get_input_manager() -> WaylandInputManager* const
     {
         return wayland_input_manager.get();
     }
 
+    auto WaylandClient::get_shm_arena() -> WaylandShmArena* const
+    {
+        return shm_arena.get();
+    }
+
+    auto WaylandClient::get_cursor_themes() -> CursorThemeCache* const
+    {
+        return cursor_themes.get();
+    }
+
+
 } // namespace tobi_engine
@@ -3,13 +3,42 @@
 #include "wayland_display.hpp"
 #include "wayland_registry.hpp"
 #include "wayland_input_manager.hpp"
+#include "wayland_shm_arena.hpp"
+#include "wayland_cursor_theme.hpp"
+#include "task_queue.hpp"
 
 #include <wayland-client-protocol.h>
+#include <coroutine>
+#include <ctime>
 #include <memory>
 
 namespace tobi_engine
 {
 
+    /**
+     * @class SyncAwaiter
+     * @brief Awaitable resumed once the compositor has processed every request sent before it.
+     */
+    class SyncAwaiter
+    {
+    public:
+
+        SyncAwaiter(wl_display* display, wl_event_queue* queue) : display(display), queue(queue) {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+
+    private:
+
+        static void done(void *data, wl_callback *callback, uint32_t serial);
+
+        wl_display* display;
+        wl_event_queue* queue;
+        WlCallbackPtr callback;
+        std::coroutine_handle<> handle;
+    };
+
     class WaylandClient
     {
     public:
@@ -17,25 +46,122 @@ namespace tobi_engine
         WaylandClient();
         ~WaylandClient() = default;
 
+        auto get_display() -> wl_display* const;
         auto get_compositor() -> wl_compositor* const;
         auto get_subcompositor() -> wl_subcompositor* const;
         auto get_shell() -> xdg_wm_base* const;
         auto get_shm() -> wl_shm* const;
+        auto get_single_pixel_buffer_manager() -> wp_single_pixel_buffer_manager_v1* const;
+        auto get_viewporter() -> wp_viewporter* const;
+        auto get_decoration_manager() -> zxdg_decoration_manager_v1* const;
+        auto get_presentation() -> wp_presentation* const;
+        auto get_tearing_control_manager() -> wp_tearing_control_manager_v1* const;
+#if defined(TOBI_HAS_FIFO_V1)
+        auto get_fifo_manager() -> wp_fifo_manager_v1* const;
+#endif
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+        auto get_commit_timing_manager() -> wp_commit_timing_manager_v1* const;
+#endif
+        /**
+         * @brief Whether cursors are set by shape instead of with themed buffers.
+         */
+        auto has_cursor_shapes() const -> bool;
+        /**
+         * @brief Clock used for presentation timestamps, as announced by wp_presentation.
+         */
+        auto get_presentation_clock() const -> clockid_t { return presentation_clock; }
         auto get_input_manager() -> WaylandInputManager* const;
+        auto get_shm_arena() -> WaylandShmArena* const;
+        auto get_cursor_themes() -> CursorThemeCache* const;
 
+        /**
+         * @brief Send buffered requests without waiting for the compositor.
+         * Round trips only happen during startup.
+         */
         auto flush() -> bool;
-        auto update() -> bool;
-        void clear();
+
+        /**
+         * @brief Flush requests, wait up to timeout_ms for events and dispatch them.
+         *
+         * Uses prepare_read/read_events around poll(), so it never blocks longer than
+         * the timeout and stays safe while other threads dispatch other queues.
+         * @param timeout_ms Milliseconds to wait; 0 polls, a negative value waits forever.
+         * @param queue Queue to dispatch; nullptr for the default queue.
+         * @param wake_fd Also return as soon as this descriptor becomes readable, e.g. a TaskQueue's.
+         * @return False if the connection failed.
+         */
+        auto dispatch(int timeout_ms, wl_event_queue* queue = nullptr, int wake_fd = -1) -> bool;
+
+        /**
+         * @brief Descriptor of the compositor connection, for polling in an external loop.
+         */
+        auto get_fd() const -> int;
+
+        /**
+         * @brief Dispatch queued events and announce the intention to read from get_fd().
+         *
+         * Must be followed by exactly one read_events() or cancel_read(), whichever
+         * applies once the descriptor was polled.
+         * @param queue Queue to dispatch; nullptr for the default queue.
+         * @return The poll events to wait for: POLLIN, plus POLLOUT while requests are
+         *         still buffered. 0 if the connection failed, with no read prepared.
+         */
+        auto prepare_read(wl_event_queue* queue = nullptr) -> short;
+
+        /**
+         * @brief Read events from get_fd() after a prepare_read() and dispatch them.
+         */
+        auto read_events(wl_event_queue* queue = nullptr) -> bool;
+        void cancel_read();
+
+        /**
+         * @brief Dispatch events already read into queue, without touching the socket.
+         */
+        auto dispatch_pending(wl_event_queue* queue) -> bool;
+
+        /**
+         * @brief Awaitable wl_display.sync, resumed by whoever dispatches queue.
+         * @param queue Queue to deliver the answer on; nullptr for the default queue.
+         */
+        auto sync(wl_event_queue* queue = nullptr) -> SyncAwaiter;
+
+        /**
+         * @brief Create an event queue, e.g. for the objects of one window.
+         */
+        auto create_event_queue() -> WlEventQueuePtr;
+
+        /**
+         * @brief Run a task on the thread dispatching the default queue. Safe from any thread.
+         */
+        void post(TaskQueue::Task task);
+
+        /**
+         * @brief Run the posted tasks; called by the thread dispatching the default queue.
+         */
+        void run_tasks();
+
+        /**
+         * @brief eventfd that becomes readable when tasks were posted to the default queue's
+         *        thread, shared by the task queues of the windows it dispatches.
+         */
+        auto get_wakeup_fd() const -> int { return tasks.get_fd(); }
 
     private:
 
         void initialize();
 
         static void shell_ping(void *data, xdg_wm_base *shell, uint32_t serial);
+        static void presentation_clock_id(void *data, wp_presentation *presentation, uint32_t clock_id);
 
         std::unique_ptr<WaylandDisplay> display;
         std::unique_ptr<WaylandRegistry> wayland_registry;
         std::unique_ptr<WaylandInputManager> wayland_input_manager;
+        std::unique_ptr<WaylandShmArena> shm_arena;
+        std::unique_ptr<CursorThemeCache> cursor_themes;
+
+        TaskQueue tasks;
+
+        clockid_t presentation_clock = CLOCK_MONOTONIC;
 
     };
 
@@ -4,10 +4,14 @@
 #include "wayland_client.hpp"
 
 #include <wayland-client-protocol.h>
-#include <wayland-cursor.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstdlib>
 #include <optional>
+#include <string_view>
+#include <utility>
 
 
 namespace tobi_engine
@@ -22,6 +26,8 @@ namespace tobi_engine
     static constexpr uint32_t DEFAULT_CURSOR_SIZE = 24;
     static constexpr std::string DEFAULT_CURSOR_THEME = "default";
     static constexpr std::string DEFAULT_CURSOR = "left_ptr";
+    // Xcursor delays of 0 would otherwise spin the main loop.
+    static constexpr uint32_t MIN_FRAME_DELAY_MS = 10;
 
     static std::string_view DEFAULT_CURSOR_SIZE_ENV = get_env_or_empty("XCURSOR_SIZE");
     static std::string_view DEFAULT_CURSOR_THEME_ENV = get_env_or_empty("XCURSOR_THEME");
@@ -67,93 +73,290 @@ namespace tobi_engine
         return std::string(cursor_theme);
     }
 
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+    // CSS names first, then the legacy X cursor font names themes still ship.
+    static constexpr std::array<std::pair<std::string_view, wp_cursor_shape_device_v1_shape>, 58> CURSOR_SHAPES = {{
+        { "default",        WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT },
+        { "context-menu",   WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CONTEXT_MENU },
+        { "help",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_HELP },
+        { "pointer",        WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_POINTER },
+        { "progress",       WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_PROGRESS },
+        { "wait",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_WAIT },
+        { "cell",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CELL },
+        { "crosshair",      WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CROSSHAIR },
+        { "text",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_TEXT },
+        { "vertical-text",  WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_VERTICAL_TEXT },
+        { "alias",          WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ALIAS },
+        { "copy",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_COPY },
+        { "move",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_MOVE },
+        { "no-drop",        WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NO_DROP },
+        { "not-allowed",    WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NOT_ALLOWED },
+        { "grab",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_GRAB },
+        { "grabbing",       WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_GRABBING },
+        { "e-resize",       WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_E_RESIZE },
+        { "n-resize",       WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_N_RESIZE },
+        { "ne-resize",      WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NE_RESIZE },
+        { "nw-resize",      WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NW_RESIZE },
+        { "s-resize",       WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_S_RESIZE },
+        { "se-resize",      WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_SE_RESIZE },
+        { "sw-resize",      WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_SW_RESIZE },
+        { "w-resize",       WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_W_RESIZE },
+        { "ew-resize",      WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_EW_RESIZE },
+        { "ns-resize",      WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NS_RESIZE },
+        { "nesw-resize",    WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NESW_RESIZE },
+        { "nwse-resize",    WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NWSE_RESIZE },
+        { "col-resize",     WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_COL_RESIZE },
+        { "row-resize",     WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ROW_RESIZE },
+        { "all-scroll",     WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ALL_SCROLL },
+        { "zoom-in",        WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ZOOM_IN },
+        { "zoom-out",       WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ZOOM_OUT },
+        { "left_ptr",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT },
+        { "question_arrow",     WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_HELP },
+        { "hand1",              WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_POINTER },
+        { "hand2",              WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_POINTER },
+        { "left_ptr_watch",     WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_PROGRESS },
+        { "watch",              WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_WAIT },
+        { "cross",              WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CROSSHAIR },
+        { "xterm",              WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_TEXT },
+        { "fleur",              WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_MOVE },
+        { "dnd-none",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NO_DROP },
+        { "crossed_circle",     WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NOT_ALLOWED },
+        { "openhand",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_GRAB },
+        { "closedhand",         WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_GRABBING },
+        { "right_side",         WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_E_RESIZE },
+        { "top_side",           WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_N_RESIZE },
+        { "top_right_corner",   WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NE_RESIZE },
+        { "top_left_corner",    WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NW_RESIZE },
+        { "bottom_side",        WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_S_RESIZE },
+        { "bottom_right_corner",WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_SE_RESIZE },
+        { "bottom_left_corner", WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_SW_RESIZE },
+        { "left_side",          WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_W_RESIZE },
+        { "sb_h_double_arrow",  WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_EW_RESIZE },
+        { "sb_v_double_arrow",  WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NS_RESIZE },
+        { "all_scroll",         WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ALL_SCROLL },
+    }};
+
+    static std::optional<wp_cursor_shape_device_v1_shape> find_cursor_shape(std::string_view name)
+    {
+        auto it = std::find_if(CURSOR_SHAPES.begin(), CURSOR_SHAPES.end(),
+            [name](const auto& entry) { return entry.first == name; });
+        if (it == CURSOR_SHAPES.end())
+            return std::nullopt;
+        return it->second;
+    }
+#endif
+
+    auto WaylandCursor::get_default_theme() -> std::string
+    {
+        return get_cursor_theme_from_env().value_or(DEFAULT_CURSOR_THEME);
+    }
+
+    auto WaylandCursor::get_default_size() -> uint32_t
+    {
+        return get_cursor_size_from_env().value_or(DEFAULT_CURSOR_SIZE);
+    }
+
     WaylandCursor::WaylandCursor(WaylandClient *client) 
         :   current_cursor_name(DEFAULT_CURSOR),
             cursor_size(0),
             client(client)
     {
-        cursor_size = get_cursor_size_from_env().value_or(DEFAULT_CURSOR_SIZE);
+        cursor_size = get_default_size();
         LOG_DEBUG("Cursor size set to: {}", cursor_size);
                 
-        current_theme_name = get_cursor_theme_from_env().value_or(DEFAULT_CURSOR_THEME);
+        current_theme_name = get_default_theme();
         LOG_DEBUG("Cursor theme set to: {}", current_theme_name);
 
-        auto shm = client->get_shm();
-        if (!shm)
+        // With cursor shapes the compositor draws the cursor; the theme and surface
+        // are only set up if a name without a shape comes along.
+        if (client->has_cursor_shapes())
         {
-            LOG_ERROR("Failed to get Wayland SHM");
-            throw std::runtime_error("Failed to get Wayland SHM");
+            LOG_DEBUG("Using wp_cursor_shape_manager_v1 for cursors");
+            return;
         }
-        theme = WlCursorThemePtr(wl_cursor_theme_load(current_theme_name.c_str(), cursor_size, shm));
-        if (!theme) 
+
+        if (!load_theme())
             throw std::runtime_error("Failed to load Wayland cursor theme " + current_theme_name);
 
+        if (!create_surface())
+            throw std::runtime_error("Failed to create Wayland cursor surface");
+    }
+
+    bool WaylandCursor::create_surface()
+    {
         auto compositor = client->get_compositor();
         if (!compositor)
         {
             LOG_ERROR("Failed to get Wayland compositor");
-            throw std::runtime_error("Failed to get Wayland compositor");
+            return false;
         }
         surface = WlSurfacePtr(wl_compositor_create_surface(compositor));
-        if(!surface)
-            throw std::runtime_error("Failed to create Wayland cursor surface");
+        return surface != nullptr;
+    }
+
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+    bool WaylandCursor::set_shape()
+    {
+        auto device = client->get_input_manager()->get_cursor_shape_device();
+        if (!device)
+            return false;
+
+        auto shape = find_cursor_shape(current_cursor_name);
+        if (!shape)
+            return false;
+
+        wp_cursor_shape_device_v1_set_shape(device, serial, *shape);
+        return true;
+    }
+#endif
+
+    bool WaylandCursor::load_theme()
+    {
+        // Every window shares the theme, so only the first one reads it from disk.
+        theme = client->get_cursor_themes()->acquire(current_theme_name, cursor_size, cursor_scale);
+        return theme != nullptr;
+    }
+
+    bool WaylandCursor::trim()
+    {
+        // An animation keeps cycling through the theme's buffers.
+        if (animation)
+            return false;
+
+        // Destroying buffers the compositor still shows is fine as long as their memory
+        // is not rewritten, and the theme unmaps it instead.
+        theme.reset();
+        return true;
+    }
+
+    void WaylandCursor::update()
+    {
+        if (!animation || std::chrono::steady_clock::now() < next_frame_time)
+            return;
+
+        auto pointer = client->get_input_manager()->get_pointer();
+        if (!pointer)
+        {
+            animation = nullptr;
+            return;
+        }
+
+        const auto& previous = animation->images[frame];
+        frame = (frame + 1) % animation->images.size();
+        const auto& image = animation->images[frame];
+
+        // The hotspot belongs to the pointer, the buffer to the surface.
+        if (image.hotspot_x != previous.hotspot_x || image.hotspot_y != previous.hotspot_y)
+            wl_pointer_set_cursor(pointer, serial, surface.get(), image.hotspot_x, image.hotspot_y);
+        attach(image);
+
+        // Keep the animation's pace, unless the loop fell more than a frame behind.
+        auto delay = std::chrono::milliseconds(std::max(image.delay, MIN_FRAME_DELAY_MS));
+        next_frame_time += delay;
+        if (auto now = std::chrono::steady_clock::now(); next_frame_time < now)
+            next_frame_time = now + delay;
+    }
+
+    auto WaylandCursor::get_timeout_ms() const -> int
+    {
+        if (!animation)
+            return -1;
+
+        auto remaining = next_frame_time - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero())
+            return 0;
+        // Round up, waking early would only mean another wait.
+        return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+    }
+
+    void WaylandCursor::attach(const CursorImage& image)
+    {
+        wl_surface_attach(surface.get(), image.buffer, 0, 0);
+        wl_surface_damage(surface.get(), 0, 0, image.width, image.height);
+        wl_surface_commit(surface.get());
     }
 
     void WaylandCursor::draw()
     {
-        wl_cursor *cursor;
-        if(cursors.contains(current_cursor_name))
+        auto input_manager = client->get_input_manager();
+        animation = nullptr;
+
+        if (current_cursor_name == "none")
         {
-            cursor = cursors[current_cursor_name];
+            wl_pointer_set_cursor(input_manager->get_pointer(), serial, nullptr, 0, 0);
+            return;
         }
-        else
+
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+        if (set_shape())
+            return;
+        LOG_DEBUG("No cursor shape for '{}', drawing it from the theme", current_cursor_name);
+#endif
+
+        if (!surface && !create_surface())
         {
-            cursor = wl_cursor_theme_get_cursor(theme.get(), current_cursor_name.c_str());
-            if (!cursor)
-            {
-                LOG_DEBUG("Cursor '{}' not found in theme, using default cursor", current_cursor_name);
-                cursor = wl_cursor_theme_get_cursor(theme.get(), DEFAULT_CURSOR.c_str());
-            }
-            if (!cursor)
-            {
-                LOG_DEBUG("Failed to load default cursor, cannot set cursor");
-                return;
-            }
-            cursors[current_cursor_name] = cursor;
+            LOG_ERROR("Failed to create Wayland cursor surface");
+            return;
         }
 
-        struct wl_cursor_image* image = cursor->images[0];
-        if (!image)
+        if (!theme && !load_theme())
         {
-            LOG_DEBUG("Failed to load cursor image for cursor: {}", current_cursor_name);
+            LOG_ERROR("Failed to reload Wayland cursor theme {}", current_theme_name);
             return;
         }
 
-        auto input_manager = client->get_input_manager();
+        auto cursor = theme->get_cursor(current_cursor_name);
+        if (!cursor)
+        {
+            LOG_DEBUG("Cursor '{}' not found in theme, using default cursor", current_cursor_name);
+            cursor = theme->get_cursor(DEFAULT_CURSOR);
+        }
+        if (!cursor)
+        {
+            LOG_DEBUG("Failed to load default cursor, cannot set cursor");
+            return;
+        }
+
+        const auto& image = cursor->images.front();
+        auto has_buffers = std::all_of(cursor->images.begin(), cursor->images.end(),
+            [](const CursorImage& frame) { return frame.buffer != nullptr; });
+        if (!has_buffers)
+        {
+            LOG_DEBUG("Failed to load cursor image for cursor: {}", current_cursor_name);
+            return;
+        }
 
         wl_pointer_set_cursor(
             input_manager->get_pointer(),
-            0, // Serial number, can be 0 for static cursors
+            serial,
             surface.get(),
-            image->hotspot_x,
-            image->hotspot_y
+            image.hotspot_x,
+            image.hotspot_y
         );
+        attach(image);
 
-        wl_surface_attach(surface.get(), wl_cursor_image_get_buffer(image), 0, 0);
-        wl_surface_damage(surface.get(), 0, 0, image->width, image->height);
-        wl_surface_commit(surface.get());
+        // Every frame already has its buffer in the theme's arena; stepping through
+        // them only re-attaches.
+        if (cursor->images.size() > 1)
+        {
+            animation = cursor;
+            frame = 0;
+            next_frame_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(image.delay, MIN_FRAME_DELAY_MS));
+        }
     }
 
-    void WaylandCursor::set_cursor(const std::string& cursor_name)
+    void WaylandCursor::set_cursor(const std::string& cursor_name, uint32_t enter_serial)
     {
         LOG_DEBUG("Setting cursor to: {}", cursor_name);
 
-        if(cursor_name == current_cursor_name)
+        // Each pointer enter needs the cursor set again, even when the name is unchanged.
+        if(cursor_name == current_cursor_name && enter_serial == serial)
         {
             LOG_DEBUG("Cursor is already set to: {}", cursor_name);
             return;
         }
         current_cursor_name = cursor_name;
+        serial = enter_serial;
 
         draw();
     }
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "wayland_client.hpp"
+#include "wayland_cursor_theme.hpp"
 #include "wayland_types.hpp"
 
-#include <string_view>
-#include <unordered_map>
+#include <chrono>
+#include <memory>
+#include <string>
 
 namespace tobi_engine
 {
@@ -19,21 +21,63 @@ namespace tobi_engine
         WaylandCursor &operator=(const WaylandCursor &) = delete;
         ~WaylandCursor() = default;
 
-        void set_cursor(const std::string& cursor_name);
+        /**
+         * @brief Show a named cursor while the pointer is over the window.
+         * @param cursor_name CSS or X cursor name, e.g. "nw-resize" or "left_ptr"; "none" hides it.
+         * @param serial Serial of the pointer enter event the cursor is set for.
+         */
+        void set_cursor(const std::string& cursor_name, uint32_t serial);
+
+        /**
+         * @brief Let go of the shared cursor theme; the last window to do so unloads it.
+         * Taken from the cache again when the cursor is next drawn.
+         * @return False while an animation keeps the theme in use.
+         */
+        bool trim();
+
+        /**
+         * @brief Show the next image of an animated cursor once its delay has passed.
+         */
+        void update();
+        /**
+         * @brief Milliseconds until update() has the next image due, -1 when not animating.
+         */
+        auto get_timeout_ms() const -> int;
+
+        /**
+         * @brief Theme and size from XCURSOR_THEME and XCURSOR_SIZE, or the defaults.
+         */
+        static auto get_default_theme() -> std::string;
+        static auto get_default_size() -> uint32_t;
     
     private:
 
         void draw();
+        void attach(const CursorImage& image);
+        bool load_theme();
+        bool create_surface();
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+        /**
+         * @brief Let the compositor draw the cursor; no theme, surface or buffers involved.
+         * @return False when the name has no shape or the pointer has no shape device.
+         */
+        bool set_shape();
+#endif
         
         WlSurfacePtr surface;
-        WlCursorThemePtr theme;
+        std::shared_ptr<CursorTheme> theme;
         WaylandClient *client;
 
-        std::unordered_map<std::string_view, wl_cursor*> cursors;
-
         std::string current_cursor_name;
         std::string current_theme_name;
+        uint32_t serial = 0;
         uint32_t cursor_size;
+        uint32_t cursor_scale = 1;
+
+        /** @brief Animated cursor being shown; owned by theme. */
+        const Cursor* animation = nullptr;
+        size_t frame = 0;
+        std::chrono::steady_clock::time_point next_frame_time;
 
     };
 
@@ -0,0 +1,197 @@
+#include "wayland_cursor_theme.hpp"
+
+#include "cursor_cache.hpp"
+#include "utils/logger.hpp"
+
+#include <wayland-client-protocol.h>
+#include <wayland-cursor.h>
+
+#include <array>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace tobi_engine
+{
+
+    namespace
+    {
+        // Looked up while prewarming, so the first pointer enter finds them ready.
+        constexpr std::array<std::string_view, 8> COMMON_CURSORS
+        {
+            "default", "left_ptr", "text", "pointer", "nw-resize", "ne-resize", "sw-resize", "se-resize"
+        };
+    }
+
+    CursorTheme::CursorTheme(const std::string& name, uint32_t size, wl_shm* shm)
+    {
+        auto directories = find_cursor_directories(name);
+        auto mtime = get_directories_mtime(directories);
+        auto cache_path = get_cursor_cache_path(name, size);
+
+        std::optional<CursorImageSet> set;
+        if (!directories.empty() && !cache_path.empty())
+            set = CursorImageSet::map(cache_path, size, mtime);
+
+        if (!set && !directories.empty())
+        {
+            set = CursorImageSet::decode(directories, size);
+            if (!set->empty() && !cache_path.empty())
+                set->write(cache_path, size, mtime);
+        }
+
+        if (set && !set->empty())
+        {
+            upload(*set, shm);
+            LOG_DEBUG("Loaded cursor theme {} at size {} with {} cursors", name, size, cursors.size());
+            return;
+        }
+
+        fallback.reset(wl_cursor_theme_load(name.c_str(), size, shm));
+        if (!fallback)
+            throw std::runtime_error("Failed to load Wayland cursor theme " + name);
+        LOG_DEBUG("Loaded cursor theme {} at size {} through libwayland-cursor", name, size);
+    }
+
+    void CursorTheme::upload(const CursorImageSet& set, wl_shm* shm)
+    {
+        auto source = set.get_pixels();
+        // The pixels are uploaded once and never grow, so reserve no more than they need.
+        const auto size = WaylandShmArena::size_class(source.size());
+        arena = std::make_unique<WaylandShmArena>(shm, size, size);
+        pixels = arena->allocate(source.size());
+        std::memcpy(arena->data(pixels), source.data(), source.size());
+
+        const auto& images = set.get_images();
+        image_blocks.reserve(images.size());
+        for (const auto& image : images)
+            image_blocks.push_back({ pixels.offset + image.offset, image.get_byte_size() });
+        buffers.resize(images.size());
+
+        for (const auto& info : set.get_cursors())
+        {
+            Entry entry;
+            entry.first_image = info.first_image;
+            for (uint32_t i = 0; i < info.image_count; ++i)
+            {
+                const auto& image = images[info.first_image + i];
+                entry.cursor.images.push_back({ image.width, image.height, image.hotspot_x, image.hotspot_y, image.delay, nullptr });
+            }
+            cursors.emplace(info.name, std::move(entry));
+        }
+    }
+
+    auto CursorTheme::get_cursor(const std::string& name) -> const Cursor*
+    {
+        std::lock_guard lock(mutex);
+        if (fallback)
+            return get_fallback_cursor(name);
+
+        auto entry = cursors.find(name);
+        if (entry == cursors.end())
+            return nullptr;
+
+        auto& [cursor, first_image, has_buffers] = entry->second;
+        if (!has_buffers)
+        {
+            // Aliases of a cursor share its images, and with them the buffers.
+            for (uint32_t i = 0; i < cursor.images.size(); ++i)
+            {
+                auto& image = cursor.images[i];
+                auto& buffer = buffers[first_image + i];
+                if (!buffer)
+                {
+                    buffer.reset(arena->create_buffer(image_blocks[first_image + i], image.width, image.height,
+                                                      image.width * 4, WL_SHM_FORMAT_ARGB8888));
+                }
+                image.buffer = buffer.get();
+            }
+            has_buffers = true;
+        }
+        return &cursor;
+    }
+
+    auto CursorTheme::get_fallback_cursor(const std::string& name) -> const Cursor*
+    {
+        auto [entry, inserted] = cursors.try_emplace(name);
+        auto& cursor = entry->second.cursor;
+        if (inserted)
+        {
+            if (auto source = wl_cursor_theme_get_cursor(fallback.get(), name.c_str()))
+            {
+                for (unsigned int i = 0; i < source->image_count; ++i)
+                {
+                    auto image = source->images[i];
+                    cursor.images.push_back({ image->width, image->height, image->hotspot_x, image->hotspot_y,
+                                              image->delay, wl_cursor_image_get_buffer(image) });
+                }
+            }
+        }
+        return cursor.images.empty() ? nullptr : &cursor;
+    }
+
+    CursorThemeCache::CursorThemeCache(wl_shm* shm)
+        : shm(shm)
+    {
+        if (!shm)
+            throw std::runtime_error("Failed to create cursor theme cache: wl_shm is null");
+    }
+
+    auto CursorThemeCache::acquire(const std::string& name, uint32_t size, uint32_t scale) -> std::shared_ptr<CursorTheme>
+    {
+        Key key { name, size, scale };
+        std::shared_future<std::shared_ptr<CursorTheme>> loading;
+        {
+            std::lock_guard lock(mutex);
+            auto& entry = themes[key];
+            if (auto theme = entry.theme.lock())
+                return theme;
+            loading = std::exchange(entry.loading, {});
+        }
+
+        std::shared_ptr<CursorTheme> theme;
+        try
+        {
+            // Loading happens outside the lock, other themes stay available meanwhile.
+            theme = loading.valid() ? loading.get() : load(key);
+        }
+        catch (const std::exception& error)
+        {
+            LOG_ERROR("{}", error.what());
+            return nullptr;
+        }
+
+        std::lock_guard lock(mutex);
+        auto& entry = themes[key];
+        // Another thread may have loaded the same theme in the meantime; keep one copy.
+        if (auto existing = entry.theme.lock())
+            return existing;
+        entry.theme = theme;
+        return theme;
+    }
+
+    void CursorThemeCache::prewarm(const std::string& name, uint32_t size, uint32_t scale)
+    {
+        Key key { name, size, scale };
+        std::lock_guard lock(mutex);
+        auto& entry = themes[key];
+        if (!entry.theme.expired() || entry.loading.valid())
+            return;
+
+        entry.loading = std::async(std::launch::async, [this, key]()
+        {
+            auto theme = load(key);
+            for (auto cursor : COMMON_CURSORS)
+                theme->get_cursor(std::string(cursor));
+            return theme;
+        }).share();
+    }
+
+    auto CursorThemeCache::load(const Key& key) const -> std::shared_ptr<CursorTheme>
+    {
+        return std::make_shared<CursorTheme>(key.name, key.size * key.scale, shm);
+    }
+
+} // namespace tobi_engine
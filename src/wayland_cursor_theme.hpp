@@ -0,0 +1,152 @@
+#pragma once
+
+#include "wayland_shm_arena.hpp"
+#include "wayland_types.hpp"
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tobi_engine
+{
+
+    class CursorImageSet;
+
+    struct CursorImage
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t hotspot_x;
+        uint32_t hotspot_y;
+        /** @brief Milliseconds until the next image of an animated cursor. */
+        uint32_t delay;
+        wl_buffer* buffer;
+    };
+
+    struct Cursor
+    {
+        std::vector<CursorImage> images;
+    };
+
+    /**
+     * @class CursorTheme
+     * @brief A loaded cursor theme and its cursor lookups, shared by every window.
+     *
+     * Decoded images are kept in a cache file under $XDG_CACHE_HOME, keyed by theme
+     * name, size and the modification time of the theme's directories, so only the
+     * first process to use a theme parses its Xcursor files. Either way all pixels
+     * reach the theme's SHM arena in a single copy, and a cursor's buffers are created
+     * on its first lookup. Themes without cursor files on disk fall back to
+     * libwayland-cursor and its built-in cursors. Lookups may happen from any thread.
+     */
+    class CursorTheme
+    {
+    public:
+
+        /**
+         * @param size Cursor size in buffer pixels, i.e. already multiplied by the scale.
+         * @throws std::runtime_error if the theme cannot be loaded.
+         */
+        CursorTheme(const std::string& name, uint32_t size, wl_shm* shm);
+        CursorTheme(const CursorTheme&) = delete;
+        CursorTheme& operator=(const CursorTheme&) = delete;
+        ~CursorTheme() = default;
+
+        /**
+         * @return The cursor, or nullptr if the theme does not have it.
+         */
+        auto get_cursor(const std::string& name) -> const Cursor*;
+
+    private:
+
+        struct Entry
+        {
+            Cursor cursor;
+            /** @brief Images in the arena; their buffers are created on first lookup. */
+            uint32_t first_image = 0;
+            bool has_buffers = false;
+        };
+
+        void upload(const CursorImageSet& set, wl_shm* shm);
+        auto get_fallback_cursor(const std::string& name) -> const Cursor*;
+
+        std::unique_ptr<WaylandShmArena> arena;
+        ShmBlock pixels;
+        std::vector<ShmBlock> image_blocks;
+        std::vector<WlBufferPtr> buffers;
+
+        WlCursorThemePtr fallback;
+
+        std::mutex mutex;
+        /** @brief Cursors keyed by name; misses of the fallback theme are kept as empty cursors. */
+        std::unordered_map<std::string, Entry> cursors;
+    };
+
+    /**
+     * @class CursorThemeCache
+     * @brief Process-wide cache of cursor themes keyed by name, size and scale.
+     *
+     * Themes are reference counted: each stays loaded while some cursor holds it and
+     * is unloaded with the last one, so opening another window never reads the theme
+     * from disk again. prewarm() loads a theme on a worker thread before it is needed;
+     * creating the pool and buffers from there is safe since nothing listens to them.
+     */
+    class CursorThemeCache
+    {
+    public:
+
+        explicit CursorThemeCache(wl_shm* shm);
+        CursorThemeCache(const CursorThemeCache&) = delete;
+        CursorThemeCache& operator=(const CursorThemeCache&) = delete;
+        ~CursorThemeCache() = default;
+
+        /**
+         * @brief Get a loaded theme, waiting for a prewarm in progress or loading it now.
+         * @return The theme, or nullptr if it cannot be loaded.
+         */
+        auto acquire(const std::string& name, uint32_t size, uint32_t scale) -> std::shared_ptr<CursorTheme>;
+
+        /**
+         * @brief Start loading a theme and looking up the common cursors on a worker thread.
+         * The result is kept until the first acquire() takes it over.
+         */
+        void prewarm(const std::string& name, uint32_t size, uint32_t scale);
+
+    private:
+
+        struct Key
+        {
+            std::string name;
+            uint32_t size;
+            uint32_t scale;
+
+            bool operator==(const Key&) const = default;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const noexcept
+            {
+                return std::hash<std::string>{}(key.name) ^ (size_t(key.size) << 1) ^ (size_t(key.scale) << 17);
+            }
+        };
+
+        struct Entry
+        {
+            std::weak_ptr<CursorTheme> theme;
+            /** @brief Prewarmed theme not acquired yet; holds the only reference until then. */
+            std::shared_future<std::shared_ptr<CursorTheme>> loading;
+        };
+
+        auto load(const Key& key) const -> std::shared_ptr<CursorTheme>;
+
+        wl_shm* shm;
+        std::mutex mutex;
+        std::unordered_map<Key, Entry, KeyHash> themes;
+    };
+
+} // namespace tobi_engine
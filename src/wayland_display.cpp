@@ -29,9 +29,38 @@ namespace tobi_engine
         return wl_display_roundtrip(display.get()) != -1;
     }
 
-    void WaylandDisplay::dispatch_pending() noexcept
+    bool WaylandDisplay::dispatch_pending(wl_event_queue* queue) noexcept
     {
-        wl_display_dispatch_pending(display.get());
+        if (queue)
+            return wl_display_dispatch_queue_pending(display.get(), queue) != -1;
+        return wl_display_dispatch_pending(display.get()) != -1;
+    }
+
+    WlEventQueuePtr WaylandDisplay::create_queue() noexcept
+    {
+        return WlEventQueuePtr(wl_display_create_queue(display.get()));
+    }
+
+    int WaylandDisplay::get_fd() const noexcept
+    {
+        return wl_display_get_fd(display.get());
+    }
+
+    bool WaylandDisplay::prepare_read(wl_event_queue* queue) noexcept
+    {
+        if (queue)
+            return wl_display_prepare_read_queue(display.get(), queue) == 0;
+        return wl_display_prepare_read(display.get()) == 0;
+    }
+
+    bool WaylandDisplay::read_events() noexcept
+    {
+        return wl_display_read_events(display.get()) != -1;
+    }
+
+    void WaylandDisplay::cancel_read() noexcept
+    {
+        wl_display_cancel_read(display.get());
     }
 
 } // namespace tobi_engine
@@ -48,9 +48,39 @@ namespace tobi_engine
         [[nodiscard]] bool roundtrip() noexcept;
 
         /**
-         * @brief Dispatch pending events.
+         * @brief Dispatch events already read from the socket, without blocking.
+         * @param queue Queue to dispatch; nullptr for the default queue.
+         * @return True if successful, false otherwise.
+         */
+        [[nodiscard]] bool dispatch_pending(wl_event_queue* queue = nullptr) noexcept;
+
+        /**
+         * @brief Create a new event queue on this connection.
+         */
+        WlEventQueuePtr create_queue() noexcept;
+
+        /**
+         * @brief File descriptor of the connection, for use with poll().
+         */
+        int get_fd() const noexcept;
+
+        /**
+         * @brief Announce the intention to read events from the socket.
+         * @param queue Queue the caller dispatches; nullptr for the default queue.
+         * @return False if that queue still holds events; dispatch them and retry.
+         */
+        [[nodiscard]] bool prepare_read(wl_event_queue* queue = nullptr) noexcept;
+
+        /**
+         * @brief Read events after a successful prepare_read().
+         * @return True if successful, false otherwise.
+         */
+        [[nodiscard]] bool read_events() noexcept;
+
+        /**
+         * @brief Give up a read announced with prepare_read().
          */
-        void dispatch_pending() noexcept;
+        void cancel_read() noexcept;
 
     private:
         WlDisplayPtr display;
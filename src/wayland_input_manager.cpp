@@ -13,6 +13,7 @@ namespace tobi_engine
 {
 
     WaylandInputManager::WaylandInputManager(const WaylandRegistry* registry)
+        : registry(registry)
     {   
         auto seat = registry->get_seat();
         if (!seat)
@@ -51,16 +52,35 @@ namespace tobi_engine
                     &WaylandInputManager::pointer_motion,
                     &WaylandInputManager::pointer_button,
                     &WaylandInputManager::pointer_axis,
+                    &WaylandInputManager::pointer_frame,
+                    &WaylandInputManager::pointer_axis_source,
+                    &WaylandInputManager::pointer_axis_stop,
+                    &WaylandInputManager::pointer_axis_discrete,
+#if defined(WL_POINTER_AXIS_VALUE120_SINCE_VERSION)
+                    &WaylandInputManager::pointer_axis_value120,
+#endif
+#if defined(WL_POINTER_AXIS_RELATIVE_DIRECTION_SINCE_VERSION)
+                    &WaylandInputManager::pointer_axis_relative_direction,
+#endif
                 };
 
                 pointer = WlPointerPtr(wl_seat_get_pointer(seat));
                 wl_pointer_add_listener(pointer.get(), &pointer_listener, this);
+                pointer_frames.set_frame_events(wl_pointer_get_version(pointer.get()) >= WL_POINTER_FRAME_SINCE_VERSION);
                 LOG_DEBUG("Pointer device added");
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+                if (auto manager = registry->get_cursor_shape_manager())
+                    cursor_shape_device.reset(wp_cursor_shape_manager_v1_get_pointer(manager, pointer.get()));
+#endif
             }
         } 
         else 
         {
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+            cursor_shape_device.reset();
+#endif
             pointer.reset();
+            pointer_frames.reset();
             LOG_DEBUG("Pointer device removed");
         }
 
@@ -133,17 +153,19 @@ namespace tobi_engine
         window->pointer_event.button = 0; // No button pressed
         window->pointer_event.state = 0; // No button pressed
 
-        window->update_cursor("nw-resize"); // Set default cursor for pointer enter
-
-        window->on_pointer_motion(wl_fixed_to_int(x), wl_fixed_to_int(y));
+        // Prewarmed with the cursor theme, so the first enter does not wait for a load.
+        window->update_cursor("left_ptr");
 
+        self->pointer_frames.enter(wl_fixed_to_double(x), wl_fixed_to_double(y));
     }
 
     void WaylandInputManager::pointer_leave(void *data, wl_pointer* poiner, uint32_t serial, wl_surface *surface)
     {
         LOG_DEBUG("pointer_leave()");
 
+        // Whatever the frame gathered before the leave still belongs to the old window.
         auto self = static_cast<WaylandInputManager*>(data);
+        self->pointer_frames.flush();
         self->unset_pointer_active_window();
 
         if (!surface)
@@ -165,25 +187,58 @@ namespace tobi_engine
 
     void WaylandInputManager::pointer_motion(void *data, wl_pointer* pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y)
     {
-        LOG_DEBUG("pointer_motion()");
-
         auto self = static_cast<WaylandInputManager*>(data);
-        self->pointer_active_window->on_pointer_motion(wl_fixed_to_int(x), wl_fixed_to_int(y));
+        self->pointer_frames.motion(time, wl_fixed_to_double(x), wl_fixed_to_double(y));
     }
 
     void WaylandInputManager::pointer_button(void *data, wl_pointer* poiner, uint32_t serial, uint32_t time, uint32_t button, uint32_t state)
     {
-        LOG_DEBUG("pointer_button()");
-        
         auto self = static_cast<WaylandInputManager*>(data);
-        self->pointer_active_window->on_pointer_button(button, state);
+        self->pointer_frames.button(time, button, state);
     }
 
     void WaylandInputManager::pointer_axis(void* data, wl_pointer* pointer, uint32_t time, uint32_t axis, wl_fixed_t value)
     {
-        LOG_DEBUG("pointer_axis()");
+        auto self = static_cast<WaylandInputManager*>(data);
+        self->pointer_frames.axis(time, axis, wl_fixed_to_double(value));
+    }
+
+    void WaylandInputManager::pointer_frame(void* data, wl_pointer* pointer)
+    {
+        auto self = static_cast<WaylandInputManager*>(data);
+        self->pointer_frames.flush();
     }
 
+    void WaylandInputManager::pointer_axis_source(void* data, wl_pointer* pointer, uint32_t axis_source)
+    {
+        auto self = static_cast<WaylandInputManager*>(data);
+        self->pointer_frames.axis_source(axis_source);
+    }
+
+    void WaylandInputManager::pointer_axis_stop(void* data, wl_pointer* pointer, uint32_t time, uint32_t axis)
+    {
+        auto self = static_cast<WaylandInputManager*>(data);
+        self->pointer_frames.axis_stop(time, axis);
+    }
+
+    void WaylandInputManager::pointer_axis_discrete(void* data, wl_pointer* pointer, uint32_t axis, int32_t discrete)
+    {
+        // Only sent before v8, which replaced it with axis_value120.
+        auto self = static_cast<WaylandInputManager*>(data);
+        self->pointer_frames.axis_value120(axis, discrete * 120);
+    }
+
+    void WaylandInputManager::pointer_axis_value120(void* data, wl_pointer* pointer, uint32_t axis, int32_t value120)
+    {
+        auto self = static_cast<WaylandInputManager*>(data);
+        self->pointer_frames.axis_value120(axis, value120);
+    }
+
+    void WaylandInputManager::pointer_axis_relative_direction(void* data, wl_pointer* pointer, uint32_t axis, uint32_t direction)
+    {
+        auto self = static_cast<WaylandInputManager*>(data);
+        self->pointer_frames.axis_relative_direction(axis, direction == WL_POINTER_AXIS_RELATIVE_DIRECTION_INVERTED);
+    }
 
     void WaylandInputManager::keyboard_map(void *data, struct wl_keyboard* keyboard, uint32_t format, int32_t fd, uint32_t size) 
     {
@@ -259,7 +314,7 @@ namespace tobi_engine
 
     void WaylandInputManager::set_pointer_active_window(Window *window) 
     {
-        this->pointer_active_window = window;
+        pointer_frames.set_window(window);
     }
 
     void WaylandInputManager::unset_keyboard_active_window() 
@@ -269,7 +324,7 @@ namespace tobi_engine
 
     void WaylandInputManager::unset_pointer_active_window() 
     {
-        this->pointer_active_window = nullptr;
+        pointer_frames.set_window(nullptr);
     }
 
 }
\ No newline at end of file
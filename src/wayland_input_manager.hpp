@@ -1,5 +1,6 @@
 #pragma once
 
+#include "pointer_frame_builder.hpp"
 #include "wayland_registry.hpp"
 #include "wayland_types.hpp"
 #include "window.hpp"
@@ -31,6 +32,13 @@ namespace tobi_engine
          * @return Pointer to the Wayland pointer device, or nullptr if not available.
          */
         auto get_pointer() const noexcept { return pointer.get(); }
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+        /**
+         * @brief Get the cursor shape device of the pointer.
+         * @return The device, or nullptr without a pointer or wp_cursor_shape_manager_v1.
+         */
+        auto get_cursor_shape_device() const noexcept { return cursor_shape_device.get(); }
+#endif
         /**
          * @brief Get the pointer to the Wayland keyboard device.
          * @return Pointer to the Wayland keyboard device, or nullptr if not available.
@@ -81,6 +89,12 @@ namespace tobi_engine
         static void pointer_motion(void *data, wl_pointer* pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y);
         static void pointer_button(void *data, wl_pointer* poiner, uint32_t serial, uint32_t time, uint32_t button, uint32_t state);
         static void pointer_axis(void* data, wl_pointer* pointer, uint32_t time, uint32_t axis, wl_fixed_t value);
+        static void pointer_frame(void* data, wl_pointer* pointer);
+        static void pointer_axis_source(void* data, wl_pointer* pointer, uint32_t axis_source);
+        static void pointer_axis_stop(void* data, wl_pointer* pointer, uint32_t time, uint32_t axis);
+        static void pointer_axis_discrete(void* data, wl_pointer* pointer, uint32_t axis, int32_t discrete);
+        static void pointer_axis_value120(void* data, wl_pointer* pointer, uint32_t axis, int32_t value120);
+        static void pointer_axis_relative_direction(void* data, wl_pointer* pointer, uint32_t axis, uint32_t direction);
 
         static void keyboard_map(void *data, struct wl_keyboard* keyboard, uint32_t format, int32_t fd, uint32_t size);
         static void keyboard_enter(void *data, struct wl_keyboard* keyboard, uint32_t serial, struct wl_surface *surface, struct wl_array* keys);
@@ -89,14 +103,19 @@ namespace tobi_engine
         static void keyboard_modifiers(void *data, struct wl_keyboard* keyboard, uint32_t serial, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group);
         static void keyboard_repeat(void *data, struct wl_keyboard* keyboard, int32_t rate, int32_t delay);
 
+        const WaylandRegistry* registry;
+
         WlPointerPtr pointer;
+        PointerFrameBuilder pointer_frames;
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+        WpCursorShapeDevicePtr cursor_shape_device;
+#endif
         WlKeyboardPtr keyboard;
         XkbContextPtr kb_context;
         XkbKeymapPtr kb_keymap;
         XkbStatePtr kb_state;
 
         Window* keyboard_active_window = nullptr;
-        Window* pointer_active_window = nullptr;
         
     };
 
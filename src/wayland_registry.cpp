@@ -34,6 +34,7 @@ WaylandRegistry::WaylandRegistry(wl_display* display, WlRegistryPtr&& reg)
         throw std::runtime_error("Failed to initialize Wayland Registry");
     }
     bind_core_protocols();
+    bind_optional_protocols();
 }
 
 WlRegistryPtr WaylandRegistry::initialize_registry(wl_display* display)
@@ -65,6 +66,24 @@ void WaylandRegistry::bind_core_protocols()
     register_interface<wl_seat>();
 }
 
+void WaylandRegistry::bind_optional_protocols()
+{
+    register_optional_interface<wp_single_pixel_buffer_manager_v1>();
+    register_optional_interface<wp_viewporter>();
+    register_optional_interface<zxdg_decoration_manager_v1>();
+    register_optional_interface<wp_presentation>();
+    register_optional_interface<wp_tearing_control_manager_v1>();
+#if defined(TOBI_HAS_FIFO_V1)
+    register_optional_interface<wp_fifo_manager_v1>();
+#endif
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+    register_optional_interface<wp_commit_timing_manager_v1>();
+#endif
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+    register_optional_interface<wp_cursor_shape_manager_v1>();
+#endif
+}
+
 wl_proxy* WaylandRegistry::bind_wayland_interface(const std::string& interface_name, const wl_interface* interface, uint32_t version)
 {
     if (!available_global_interfaces.contains(interface_name)) 
@@ -68,6 +68,56 @@ namespace tobi_engine
         {
             return get_interface<wl_seat>();
         }
+        /**
+         * @brief Optional: nullptr if the compositor does not support single pixel buffers.
+         */
+        wp_single_pixel_buffer_manager_v1* get_single_pixel_buffer_manager() const noexcept
+        {
+            return get_optional_interface<wp_single_pixel_buffer_manager_v1>();
+        }
+        /**
+         * @brief Optional: nullptr if the compositor does not support viewports.
+         */
+        wp_viewporter* get_viewporter() const noexcept
+        {
+            return get_optional_interface<wp_viewporter>();
+        }
+        /**
+         * @brief Optional: nullptr if the compositor cannot negotiate server-side decorations.
+         */
+        zxdg_decoration_manager_v1* get_decoration_manager() const noexcept
+        {
+            return get_optional_interface<zxdg_decoration_manager_v1>();
+        }
+        /**
+         * @brief Optional: nullptr if the compositor does not report presentation timing.
+         */
+        wp_presentation* get_presentation() const noexcept
+        {
+            return get_optional_interface<wp_presentation>();
+        }
+        wp_tearing_control_manager_v1* get_tearing_control_manager() const noexcept
+        {
+            return get_optional_interface<wp_tearing_control_manager_v1>();
+        }
+#if defined(TOBI_HAS_FIFO_V1)
+        wp_fifo_manager_v1* get_fifo_manager() const noexcept
+        {
+            return get_optional_interface<wp_fifo_manager_v1>();
+        }
+#endif
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+        wp_commit_timing_manager_v1* get_commit_timing_manager() const noexcept
+        {
+            return get_optional_interface<wp_commit_timing_manager_v1>();
+        }
+#endif
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+        wp_cursor_shape_manager_v1* get_cursor_shape_manager() const noexcept
+        {
+            return get_optional_interface<wp_cursor_shape_manager_v1>();
+        }
+#endif
 
     private:
     
@@ -87,6 +137,7 @@ namespace tobi_engine
         static WlRegistryPtr initialize_registry(wl_display* display);
 
         void bind_core_protocols();
+        void bind_optional_protocols();
 
         /**
          * @brief Get the Wayland protocol interface pointer.
@@ -106,6 +157,16 @@ namespace tobi_engine
             }
         }
 
+        /**
+         * @brief Get an optional protocol interface pointer.
+         * @return Pointer to the Wayland interface, or nullptr if it was not advertised.
+         */
+        template <typename T>
+        T* get_optional_interface() const noexcept
+        {
+            return std::get<WlUniquePtr<T>>(optional_protocols).get();
+        }
+
         /**
          * @brief C callback: called when a global is added to the registry.
          */
@@ -155,10 +216,33 @@ namespace tobi_engine
             std::get<WlUniquePtr<WaylandInterface>>(global_protocols).reset(proxy);
         }
 
+        /**
+         * @brief Bind an optional Wayland interface if the compositor advertises it.
+         * @tparam WaylandInterface The protocol type to bind.
+         * @return True if the interface was bound.
+         */
+        template<typename WaylandInterface>
+        bool register_optional_interface(uint32_t required_version = WaylandInterfaceTraits<WaylandInterface>::version)
+        {
+            if (!available_global_interfaces.contains(WaylandInterfaceTraits<WaylandInterface>::interface_name))
+            {
+                LOG_DEBUG("Optional Wayland interface {} is not available", WaylandInterfaceTraits<WaylandInterface>::interface_name);
+                return false;
+            }
+
+            auto proxy = reinterpret_cast<WaylandInterface*>(bind_wayland_interface(WaylandInterfaceTraits<WaylandInterface>::interface_name,
+                  WaylandInterfaceTraits<WaylandInterface>::interface,
+                  required_version));
+
+            std::get<WlUniquePtr<WaylandInterface>>(optional_protocols).reset(proxy);
+            return true;
+        }
+
         wl_proxy* bind_wayland_interface(const std::string& interface_name, const wl_interface* interface, uint32_t version);
 
         WlRegistryPtr registry;
         CoreProtocols global_protocols{};
+        OptionalProtocols optional_protocols{};
 
         /**
          * @brief Tracks interfaces that have been registered and are currently available.
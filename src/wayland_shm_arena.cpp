@@ -0,0 +1,199 @@
+#include "wayland_shm_arena.hpp"
+
+#include "utils/logger.hpp"
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client-protocol.h>
+
+namespace tobi_engine
+{
+
+    namespace
+    {
+        constexpr size_t align_up(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    WaylandShmArena::WaylandShmArena(wl_shm* shm, size_t initial_size, size_t max_size)
+    {
+        if (!shm)
+            throw std::runtime_error("Failed to create SHM arena: wl_shm is null");
+
+        auto name = std::string("/tobi-shm-arena-").append(generate_random_string(10));
+
+        file_descriptor = memfd_create(name.c_str(), MFD_CLOEXEC);
+        if (file_descriptor == -1)
+            throw std::runtime_error("Failed to create SHM arena file " + name);
+
+        capacity = std::min(align_up(std::max(initial_size, ALIGNMENT), ALIGNMENT), MAX_SIZE);
+        reserved_size = std::clamp(align_up(max_size, ALIGNMENT), capacity, MAX_SIZE);
+        if (ftruncate(file_descriptor, capacity) == -1)
+        {
+            close(file_descriptor);
+            throw std::runtime_error("Failed to truncate SHM arena file " + name);
+        }
+
+        // Reserving the whole range costs address space only; growth maps the file into it.
+        auto reservation = mmap(nullptr, reserved_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (reservation == MAP_FAILED)
+        {
+            close(file_descriptor);
+            throw std::runtime_error("Failed to reserve SHM arena address range");
+        }
+        memory = static_cast<uint8_t*>(reservation);
+
+        if (mmap(memory, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, file_descriptor, 0) == MAP_FAILED)
+        {
+            munmap(memory, reserved_size);
+            close(file_descriptor);
+            throw std::runtime_error("Failed to map SHM arena");
+        }
+
+        pool.reset(wl_shm_create_pool(shm, file_descriptor, static_cast<int32_t>(capacity)));
+        if (!pool)
+        {
+            munmap(memory, reserved_size);
+            close(file_descriptor);
+            throw std::runtime_error("Failed to create SHM arena pool");
+        }
+
+        blocks.add(0, capacity);
+        LOG_DEBUG("Created SHM arena {} with {} bytes", name, capacity);
+    }
+
+    WaylandShmArena::~WaylandShmArena()
+    {
+        // Their blocks go away with the file, but the proxies have to be destroyed.
+        retired_buffers.clear();
+        pool.reset();
+        if (memory)
+            munmap(memory, reserved_size);
+        if (file_descriptor != -1)
+            close(file_descriptor);
+    }
+
+    auto WaylandShmArena::allocate(size_t size) -> ShmBlock
+    {
+        std::lock_guard lock(mutex);
+        if (auto block = blocks.allocate(size))
+            return block;
+
+        grow(size_class(size));
+        return blocks.allocate(size);
+    }
+
+    void WaylandShmArena::free(const ShmBlock& block) noexcept
+    {
+        std::lock_guard lock(mutex);
+        blocks.free(block);
+    }
+
+    void WaylandShmArena::flush_recycled() noexcept
+    {
+        std::lock_guard lock(mutex);
+        blocks.flush_recycled();
+    }
+
+    void WaylandShmArena::trim() noexcept
+    {
+        std::lock_guard lock(mutex);
+        blocks.flush_recycled();
+        for (auto [offset, size] : blocks.get_free_blocks())
+            discard({ offset, size });
+    }
+
+    void WaylandShmArena::discard(const ShmBlock& block) noexcept
+    {
+        if (!block)
+            return;
+
+        // MADV_DONTNEED would only drop this mapping's view of a shared file; punching a
+        // hole frees the memfd pages themselves. MADV_REMOVE does the same on older kernels.
+        if (fallocate(file_descriptor, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, block.offset, block.size) == -1 &&
+            madvise(memory + block.offset, block.size, MADV_REMOVE) == -1)
+        {
+            LOG_WARNING("Failed to discard {} bytes of the SHM arena", block.size);
+        }
+    }
+
+    void WaylandShmArena::retire(wl_buffer* buffer, const ShmBlock& block, std::shared_ptr<void> owner)
+    {
+        std::lock_guard lock(mutex);
+        retired_buffers.insert_or_assign(buffer, RetiredBuffer{ block, std::move(owner) });
+    }
+
+    void WaylandShmArena::release_retired(wl_buffer* buffer) noexcept
+    {
+        // The owner may be the listener data of the release being dispatched, so it is
+        // dropped last, and outside the lock since it destroys the buffer.
+        std::shared_ptr<void> owner;
+        {
+            std::lock_guard lock(mutex);
+            auto retired = retired_buffers.find(buffer);
+            if (retired == retired_buffers.end())
+                return;
+
+            blocks.free(retired->second.block);
+            owner = std::move(retired->second.owner);
+            retired_buffers.erase(retired);
+        }
+    }
+
+    auto WaylandShmArena::get_capacity() const -> size_t
+    {
+        std::lock_guard lock(mutex);
+        return capacity;
+    }
+
+    void WaylandShmArena::grow(size_t minimum_size)
+    {
+        auto new_capacity = std::max(capacity * 2, capacity + minimum_size);
+        new_capacity = std::min(align_up(new_capacity, ALIGNMENT), reserved_size);
+        if (new_capacity < capacity + minimum_size)
+        {
+            LOG_ERROR("SHM arena exhausted: {} bytes requested with {} in use", minimum_size, capacity);
+            throw std::runtime_error("SHM arena exhausted");
+        }
+
+        if (ftruncate(file_descriptor, new_capacity) == -1)
+            throw std::runtime_error("Failed to grow SHM arena file");
+
+        // Map only the new part, in place, so blocks other threads are drawing into stay put.
+        if (mmap(memory + capacity, new_capacity - capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                 file_descriptor, static_cast<off_t>(capacity)) == MAP_FAILED)
+        {
+            throw std::runtime_error("Failed to map grown SHM arena");
+        }
+
+        wl_shm_pool_resize(pool.get(), static_cast<int32_t>(new_capacity));
+
+        LOG_DEBUG("Grew SHM arena from {} to {} bytes", capacity, new_capacity);
+
+        auto old_capacity = capacity;
+        capacity = new_capacity;
+        blocks.add(old_capacity, new_capacity - old_capacity);
+    }
+
+    auto WaylandShmArena::create_buffer(const ShmBlock& block, int32_t width, int32_t height, int32_t stride, uint32_t format) -> wl_buffer*
+    {
+        if (static_cast<size_t>(stride) * height > block.size)
+        {
+            LOG_ERROR("Buffer {}x{} does not fit in a block of {} bytes", width, height, block.size);
+            return nullptr;
+        }
+        // Keeps the request ordered after the wl_shm_pool_resize covering the block.
+        std::lock_guard lock(mutex);
+        return wl_shm_pool_create_buffer(pool.get(), static_cast<int32_t>(block.offset), width, height, stride, format);
+    }
+
+} // namespace tobi_engine
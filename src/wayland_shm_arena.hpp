@@ -0,0 +1,124 @@
+#pragma once
+
+#include "shm_block_allocator.hpp"
+#include "wayland_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace tobi_engine
+{
+
+    /**
+     * @class WaylandShmArena
+     * @brief One memfd and one wl_shm_pool shared by every buffer of a connection.
+     *
+     * Blocks are handed out by a ShmBlockAllocator, which reuses freed blocks of the same
+     * size class, so allocating a buffer in the steady state costs no syscalls. When it
+     * cannot satisfy a request the file is grown and the pool enlarged with
+     * wl_shm_pool_resize.
+     *
+     * The address range for the largest allowed size is reserved up front and every
+     * growth maps the new part of the file into it, so block memory never moves.
+     * Windows with their own dispatch thread share the arena, so every member is safe to
+     * call from any thread; data() needs no lock since the mapping is stable.
+     */
+    class WaylandShmArena
+    {
+    public:
+
+        /**
+         * @brief Create the backing memfd, mapping and pool.
+         * @param shm Bound wl_shm global; must not be null.
+         * @param initial_size Initial arena size in bytes.
+         * @param max_size Size the arena may grow to; its address range is reserved right away.
+         * @throws std::runtime_error if any of the resources cannot be created.
+         */
+        explicit WaylandShmArena(wl_shm* shm, size_t initial_size = DEFAULT_INITIAL_SIZE, size_t max_size = MAX_SIZE);
+        WaylandShmArena(const WaylandShmArena&) = delete;
+        WaylandShmArena& operator=(const WaylandShmArena&) = delete;
+        ~WaylandShmArena();
+
+        /**
+         * @brief Reserve a block of at least size bytes, rounded up to its size class.
+         * @throws std::runtime_error if the arena cannot grow any further.
+         */
+        auto allocate(size_t size) -> ShmBlock;
+        /**
+         * @brief Return a block to its size class bin, or to the free list when the bin or
+         *        the bytes held by all bins are at their limit.
+         */
+        void free(const ShmBlock& block) noexcept;
+        /**
+         * @brief Move every binned block to the free list, where it coalesces with its
+         *        neighbours. Worth calling once a burst of reallocations, e.g. a resize, settles.
+         */
+        void flush_recycled() noexcept;
+        /**
+         * @brief Flush the bins and give the pages of every free block back to the kernel.
+         */
+        void trim() noexcept;
+        /**
+         * @brief Give the pages of a block back to the kernel. The block stays reserved
+         *        and reads back as zeros, so it can still be reused or freed.
+         */
+        void discard(const ShmBlock& block) noexcept;
+
+        /**
+         * @brief Keep the block of a buffer the compositor still holds reserved until the
+         *        buffer is released, for owners that go away before the release arrives.
+         * @param owner Keeps the buffer proxy and its listener data alive until release_retired().
+         */
+        void retire(wl_buffer* buffer, const ShmBlock& block, std::shared_ptr<void> owner);
+        /**
+         * @brief Free the block of a retired buffer and drop its owner, destroying the buffer.
+         */
+        void release_retired(wl_buffer* buffer) noexcept;
+
+        /**
+         * @brief Create a wl_buffer viewing part of a block.
+         */
+        auto create_buffer(const ShmBlock& block, int32_t width, int32_t height, int32_t stride, uint32_t format) -> wl_buffer*;
+
+        auto data(const ShmBlock& block) const noexcept -> uint8_t* { return memory + block.offset; }
+        auto get_capacity() const -> size_t;
+        auto get_fd() const noexcept -> int32_t { return file_descriptor; }
+
+        static constexpr auto size_class(size_t size) noexcept -> size_t { return ShmBlockAllocator::size_class(size); }
+
+        static constexpr size_t ALIGNMENT = ShmBlockAllocator::ALIGNMENT;
+        static constexpr size_t DEFAULT_INITIAL_SIZE = 4 * 1024 * 1024;
+        /** @brief wl_shm_pool sizes and offsets are signed 32-bit on the wire. */
+        static constexpr size_t MAX_SIZE = size_t(std::numeric_limits<int32_t>::max()) & ~(ALIGNMENT - 1);
+
+    private:
+
+        // Expects the mutex to be held.
+        void grow(size_t minimum_size);
+
+        int32_t file_descriptor = -1;
+        uint8_t* memory = nullptr;
+        size_t reserved_size = 0;
+        size_t capacity = 0;
+        WlShmPoolPtr pool;
+
+        mutable std::mutex mutex;
+
+        ShmBlockAllocator blocks;
+
+        struct RetiredBuffer
+        {
+            ShmBlock block;
+            std::shared_ptr<void> owner;
+        };
+        /**
+         * @brief Buffers still held by the compositor after their owner was destroyed.
+         */
+        std::unordered_map<wl_buffer*, RetiredBuffer> retired_buffers;
+    };
+
+} // namespace tobi_engine
@@ -3,7 +3,9 @@
 #include "wayland_client.hpp"
 #include "wayland_types.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <ctime>
 #include <memory>
 #include <string>
 #include <sys/types.h>
@@ -12,17 +14,19 @@
 namespace tobi_engine
 {
 
-    WaylandSurface::WaylandSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent)
-        : width(width), height(height), client(client)
+    WaylandSurface::WaylandSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent, wl_event_queue *queue)
+        : width(width), height(height), client(client), event_queue(parent ? parent->get_event_queue() : queue)
     {
         LOG_DEBUG("Width: {}, heigth: {}", width, height);
 
-        buffer = std::make_unique<SurfaceBuffer>(width, height, client);
-        surface = WlSurfacePtr(wl_compositor_create_surface(client->get_compositor()));
-        create_subsurface(parent);
-
-        wl_surface_attach(surface.get(), buffer->get_buffer(), 0, 0);
+        buffer = std::make_unique<SurfaceBuffer>(width, height, client, PresentMode::Mailbox, event_queue);
 
+        // Created through a wrapper so the surface, and the frame callbacks created from
+        // it, belong to the window's queue from the start.
+        auto compositor = create_queue_wrapper(client->get_compositor(), event_queue);
+        surface = WlSurfacePtr(wl_compositor_create_surface(compositor.get()));
+        create_subsurface(parent);
+        damage_all();
     }
 
     void WaylandSurface::create_subsurface(const WaylandSurface *parent)
@@ -37,17 +41,350 @@ namespace tobi_engine
             throw std::runtime_error("Failed to get Wayland subcompositor");
         }
 
+        // Subsurfaces stay synchronized, so their state is applied together with the
+        // parent's commit and the whole tree updates atomically.
         subsurface = WlSubSurfacePtr(wl_subcompositor_get_subsurface(subcompositor, surface.get(), parent->get_surface()));
-        wl_subsurface_set_desync(subsurface.get());
-        wl_subsurface_set_position(subsurface.get(), DECORATIONS_BORDER_SIZE, DECORATIONS_TOPBAR_SIZE);
     }
 
-    void WaylandSurface::draw()
+    void WaylandSurface::set_position(int32_t x, int32_t y)
+    {
+        if (subsurface)
+            wl_subsurface_set_position(subsurface.get(), x, y);
+    }
+
+    auto WaylandSurface::draw(bool force_commit) -> DrawResult
+    {
+        if (pending_damage.empty())
+        {
+            if (!force_commit)
+                return DrawResult::Skipped;
+            commit();
+            return DrawResult::Committed;
+        }
+
+        if (solid_buffer)
+            return draw_solid();
+
+        // Never draw into a buffer the compositor may still be reading from.
+        if (!buffer->acquire())
+        {
+            LOG_DEBUG("No free buffer, dropping frame");
+            if (!force_commit)
+                return DrawResult::Skipped;
+            commit();
+            return DrawResult::Committed;
+        }
+
+        const Rect bounds { 0, 0, int32_t(buffer->get_width()), int32_t(buffer->get_height()) };
+
+        // The slot still shows the frame it was last presented with, so everything damaged
+        // since then has to be repainted as well. Unknown contents need a full repaint.
+        auto repaint = pending_damage;
+        auto age = buffer->get_age();
+        if (age == 0 || age - 1 > damage_history.size())
+        {
+            repaint.add(bounds);
+        }
+        else
+        {
+            for (uint32_t i = 0; i + 1 < age; ++i)
+                repaint.add(damage_history[i]);
+        }
+
+        for (const auto& rect : repaint.rects())
+        {
+            if (auto clipped = rect.intersected(bounds); !clipped.empty())
+                paint(clipped);
+        }
+
+        wl_surface_attach(surface.get(), buffer->present(), 0, 0);
+
+        const bool damage_in_buffer_coordinates = wl_surface_get_version(surface.get()) >= WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION;
+        for (const auto& rect : pending_damage.rects())
+        {
+            if (damage_in_buffer_coordinates)
+                wl_surface_damage_buffer(surface.get(), rect.x, rect.y, rect.width, rect.height);
+            else
+                wl_surface_damage(surface.get(), rect.x, rect.y, rect.width, rect.height);
+        }
+        commit();
+
+        std::move_backward(damage_history.begin(), damage_history.end() - 1, damage_history.end());
+        damage_history.front() = pending_damage;
+        pending_damage.clear();
+
+        return DrawResult::Repainted;
+    }
+
+    auto WaylandSurface::draw_solid() -> DrawResult
     {
-        buffer->fill(clear_colour);
+        // The viewport scales the 1x1 buffer to the surface size, so there is nothing to
+        // paint: a resize only changes the destination.
+        wl_surface_attach(surface.get(), solid_buffer.get(), 0, 0);
+        wp_viewport_set_destination(viewport.get(), width, height);
 
-        wl_surface_damage(surface.get(), 0, 0, buffer->get_width(), buffer->get_height());
+        if (wl_surface_get_version(surface.get()) >= WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION)
+            wl_surface_damage_buffer(surface.get(), 0, 0, 1, 1);
+        else
+            wl_surface_damage(surface.get(), 0, 0, width, height);
+        commit();
+
+        pending_damage.clear();
+        return DrawResult::Repainted;
+    }
+
+    bool WaylandSurface::set_solid_colour(uint32_t colour)
+    {
+        if (!create_solid_buffer(colour))
+            return false;
+
+        clear_colour = colour;
+        buffer.reset();
+        damage_history = {};
+        damage_all();
+        return true;
+    }
+
+    bool WaylandSurface::set_placeholder(bool enable)
+    {
+        // Surfaces without a swapchain are solid already.
+        if (!buffer || enable == bool(solid_buffer))
+            return true;
+
+        if (enable)
+        {
+            if (!create_solid_buffer(clear_colour))
+                return false;
+        }
+        else
+        {
+            // The destination would keep scaling the SHM buffers otherwise.
+            solid_buffer.reset();
+            wp_viewport_set_destination(viewport.get(), -1, -1);
+            damage_history = {};
+        }
+        damage_all();
+        return true;
+    }
+
+    void WaylandSurface::trim()
+    {
+        if (!buffer)
+            return;
+
+        buffer->trim();
+        damage_history = {};
+    }
+
+    bool WaylandSurface::create_solid_buffer(uint32_t colour)
+    {
+        auto manager = client->get_single_pixel_buffer_manager();
+        auto viewporter = client->get_viewporter();
+        if (!manager || !viewporter)
+        {
+            LOG_DEBUG("Single pixel buffers not supported, using SHM buffers");
+            return false;
+        }
+
+        // Channels are 32-bit premultiplied values; scaling by 0x01010101 maps 0xFF to 0xFFFFFFFF.
+        auto channel = [colour](uint32_t shift) { return ((colour >> shift) & 0xFF) * 0x01010101u; };
+        solid_buffer = WlBufferPtr(wp_single_pixel_buffer_manager_v1_create_u32_rgba_buffer(manager,
+            channel(16), channel(8), channel(0), channel(24)));
+        if (event_queue)
+            wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(solid_buffer.get()), event_queue);
+        if (!viewport)
+            viewport = WpViewportPtr(wp_viewporter_get_viewport(viewporter, surface.get()));
+        return true;
+    }
+
+    void WaylandSurface::commit()
+    {
+        request_presentation_feedback();
+
+#if defined(TOBI_HAS_FIFO_V1)
+        // Wait for the previous commit's barrier, then place one for the next commit.
+        if (fifo && !skip_barrier)
+        {
+            wp_fifo_v1_wait_barrier(fifo.get());
+            wp_fifo_v1_set_barrier(fifo.get());
+        }
+#endif
+        skip_barrier = false;
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+        if (commit_timer && target_presentation_ns)
+        {
+            auto seconds = target_presentation_ns / 1'000'000'000;
+            wp_commit_timer_v1_set_timestamp(commit_timer.get(), uint32_t(seconds >> 32), uint32_t(seconds),
+                uint32_t(target_presentation_ns % 1'000'000'000));
+        }
+#endif
+        target_presentation_ns = 0;
+
+        wl_surface_commit(surface.get());
+    }
+
+    void WaylandSurface::unmap()
+    {
+        wl_surface_attach(surface.get(), nullptr, 0, 0);
         wl_surface_commit(surface.get());
+        damage_history = {};
+        damage_all();
+    }
+
+    void WaylandSurface::set_tearing(bool allow)
+    {
+        if (!tearing_control)
+        {
+            auto manager = client->get_tearing_control_manager();
+            if (!manager)
+                return;
+            tearing_control = WpTearingControlPtr(wp_tearing_control_manager_v1_get_tearing_control(manager, surface.get()));
+        }
+
+        // Double-buffered: takes effect with the next commit.
+        wp_tearing_control_v1_set_presentation_hint(tearing_control.get(), allow
+            ? WP_TEARING_CONTROL_V1_PRESENTATION_HINT_ASYNC
+            : WP_TEARING_CONTROL_V1_PRESENTATION_HINT_VSYNC);
+    }
+
+    bool WaylandSurface::set_fifo(bool enable)
+    {
+#if defined(TOBI_HAS_FIFO_V1)
+        if (!enable)
+        {
+            fifo.reset();
+            return true;
+        }
+        if (!fifo)
+        {
+            auto manager = client->get_fifo_manager();
+            if (!manager)
+                return false;
+            fifo = WpFifoPtr(wp_fifo_manager_v1_get_fifo(manager, surface.get()));
+        }
+        return true;
+#else
+        return !enable;
+#endif
+    }
+
+    void WaylandSurface::set_target_presentation_time(uint64_t time_ns)
+    {
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+        if (!commit_timer)
+        {
+            auto manager = client->get_commit_timing_manager();
+            if (!manager)
+                return;
+            commit_timer = WpCommitTimerPtr(wp_commit_timing_manager_v1_get_timer(manager, surface.get()));
+        }
+#endif
+        target_presentation_ns = time_ns;
+    }
+
+    void WaylandSurface::request_presentation_feedback()
+    {
+        auto presentation = client->get_presentation();
+        if (!frame_timeline || !presentation)
+            return;
+
+        static constexpr wp_presentation_feedback_listener feedback_listener
+        {
+            &WaylandSurface::feedback_sync_output,
+            &WaylandSurface::feedback_presented,
+            &WaylandSurface::feedback_discarded
+        };
+
+        timespec now{};
+        clock_gettime(client->get_presentation_clock(), &now);
+
+        auto& entry = pending_feedback.emplace_back(std::make_unique<PresentationFeedback>());
+        entry->surface = this;
+        entry->commit_time_ns = uint64_t(now.tv_sec) * 1'000'000'000 + uint64_t(now.tv_nsec);
+        entry->feedback = WpPresentationFeedbackPtr(wp_presentation_feedback(presentation, surface.get()));
+        // No feedback event can arrive before the commit, so moving the queue here is safe.
+        if (event_queue)
+            wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(entry->feedback.get()), event_queue);
+        wp_presentation_feedback_add_listener(entry->feedback.get(), &feedback_listener, entry.get());
+    }
+
+    void WaylandSurface::feedback_sync_output(void *data, struct wp_presentation_feedback *feedback, wl_output *output)
+    {
+    }
+
+    void WaylandSurface::feedback_presented(void *data, struct wp_presentation_feedback *feedback, uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                            uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags)
+    {
+        auto entry = static_cast<PresentationFeedback*>(data);
+        auto seconds = (uint64_t(tv_sec_hi) << 32) | tv_sec_lo;
+        auto presented_ns = seconds * 1'000'000'000 + tv_nsec;
+        auto latency_ns = presented_ns > entry->commit_time_ns ? presented_ns - entry->commit_time_ns : 0;
+
+        if (auto timeline = entry->surface->frame_timeline)
+            timeline->record_presented(latency_ns, refresh, presented_ns);
+        entry->surface->finish_feedback(entry);
+    }
+
+    void WaylandSurface::feedback_discarded(void *data, struct wp_presentation_feedback *feedback)
+    {
+        auto entry = static_cast<PresentationFeedback*>(data);
+        if (auto timeline = entry->surface->frame_timeline)
+            timeline->record_discarded();
+        entry->surface->finish_feedback(entry);
+    }
+
+    void WaylandSurface::finish_feedback(PresentationFeedback *feedback)
+    {
+        std::erase_if(pending_feedback, [feedback](const auto& entry) { return entry.get() == feedback; });
+    }
+
+    void WaylandSurface::paint(const Rect& rect)
+    {
+        buffer->fill_rect(rect.x, rect.y, rect.width, rect.height, clear_colour);
+    }
+
+    void WaylandSurface::set_opaque(bool opaque)
+    {
+        if (this->opaque == opaque)
+            return;
+        this->opaque = opaque;
+
+        // Both formats are mandatory for every compositor, so there is nothing to query.
+        auto format = opaque ? WL_SHM_FORMAT_XRGB8888 : WL_SHM_FORMAT_ARGB8888;
+        if (buffer)
+            buffer->set_format(format);
+
+        update_regions();
+        damage_all();
+    }
+
+    auto WaylandSurface::create_region() const -> WlRegionPtr
+    {
+        return WlRegionPtr(wl_compositor_create_region(client->get_compositor()));
+    }
+
+    void WaylandSurface::update_regions()
+    {
+        if (!opaque)
+        {
+            wl_surface_set_opaque_region(surface.get(), nullptr);
+            return;
+        }
+
+        auto region = create_region();
+        wl_region_add(region.get(), 0, 0, width, height);
+        wl_surface_set_opaque_region(surface.get(), region.get());
+    }
+
+    void WaylandSurface::damage(const Rect& rect)
+    {
+        pending_damage.add(rect);
+    }
+
+    void WaylandSurface::damage_all()
+    {
+        pending_damage.clear();
+        pending_damage.add({ 0, 0, int32_t(width), int32_t(height) });
     }
 
     void WaylandSurface::resize(uint32_t width, uint32_t height)
@@ -56,29 +393,39 @@ namespace tobi_engine
             return;
         this->width = width;
         this->height = height;
-        buffer->resize(this->width, this->height);
-        wl_surface_attach(surface.get(), buffer->get_buffer(), 0, 0);
-
-        draw();
+        if (buffer)
+            buffer->resize(this->width, this->height);
+        update_regions();
+        damage_all();
     }
 
 
 
-    DecorationSurface::DecorationSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent)
-        :   WaylandSurface( width + this->DECORATIONS_BORDER_SIZE * 2, 
-                            height + this->DECORATIONS_BORDER_SIZE + this->DECORATIONS_TOPBAR_SIZE, 
-                            client, parent)
+    DecorationSurface::DecorationSurface(Edge edge, uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent)
+        :   WaylandSurface( geometry(edge, width, height).width,
+                            geometry(edge, width, height).height,
+                            client, parent),
+            edge(edge)
     {
+        auto strip = geometry(edge, width, height);
+        set_position(strip.x, strip.y);
+
         this->clear_colour = 0xFF00DDDD;
+        set_solid_colour(clear_colour);
+        set_opaque(true);
     }
     void DecorationSurface::resize(uint32_t width, uint32_t height)
     {
-        WaylandSurface::resize(width + DECORATIONS_BORDER_SIZE * 2, height + DECORATIONS_TOPBAR_SIZE + DECORATIONS_BORDER_SIZE);
+        // The right and bottom strips move even when their size does not change.
+        auto strip = geometry(edge, width, height);
+        set_position(strip.x, strip.y);
+        WaylandSurface::resize(strip.width, strip.height);
     }
-    ContentSurface::ContentSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent)
-        :   WaylandSurface(width, height, client, parent)
+    ContentSurface::ContentSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent, wl_event_queue *queue)
+        :   WaylandSurface(width, height, client, parent, queue)
     {
         this->clear_colour = 0xFFFFFFFF;
+        set_opaque(true);
     }
     CursorSurface::CursorSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent)
         :   WaylandSurface(width, height, client, parent)
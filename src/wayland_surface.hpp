@@ -1,10 +1,15 @@
 #pragma once
 
+#include "damage_region.hpp"
+#include "frame_timeline.hpp"
 #include "wayland_client.hpp"
 #include "wayland_types.hpp"
 #include "wayland_surface_buffer.hpp"
 
+#include <array>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace tobi_engine
 {
@@ -14,7 +19,17 @@ namespace tobi_engine
     public:
         enum class Type { Decoration, Content, Popup, Overlay, Cursor };
 
-        WaylandSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent = nullptr);
+        /**
+         * @brief Outcome of draw(): nothing committed, a commit without a new buffer, or a
+         *        commit that painted or attached one.
+         */
+        enum class DrawResult { Skipped, Committed, Repainted };
+
+        /**
+         * @param queue Event queue for the surface and its buffers; subsurfaces inherit
+         *              their parent's queue, nullptr selects the default queue.
+         */
+        WaylandSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent = nullptr, wl_event_queue *queue = nullptr);
         WaylandSurface(WaylandSurface &&) = default;
         WaylandSurface(const WaylandSurface &) = delete;
         WaylandSurface &operator=(WaylandSurface &&) = default;
@@ -24,21 +39,133 @@ namespace tobi_engine
         virtual Type get_type() const = 0;
 
         wl_surface* get_surface() const { return surface.get(); }
-        wl_buffer*  get_buffer() const { return buffer.get()->get_buffer(); }
+        wl_event_queue* get_event_queue() const { return event_queue; }
+        wl_buffer*  get_buffer() const { return buffer ? buffer->get_buffer() : solid_buffer.get(); }
+
+        /**
+         * @brief Repaint the damaged parts of the surface and commit them.
+         * @param force_commit Commit even when nothing was damaged, e.g. to ack a configure.
+         */
+        DrawResult draw(bool force_commit = false);
+        bool has_damage() const { return !pending_damage.empty(); }
+        void commit();
 
-        void draw();
+        /**
+         * @brief Detach the buffer so the surface disappears with its next applied commit.
+         * Subsurfaces stay visible until their parent commits as well.
+         */
+        void unmap();
+
+        /**
+         * @brief Mark a rectangle, in buffer coordinates, for repaint on the next draw().
+         */
+        void damage(const Rect& rect);
+        void damage_all();
 
         virtual void resize(uint32_t width, uint32_t height);
+
+        /**
+         * @brief Move a subsurface relative to its parent. Applied on the parent's next commit.
+         */
+        void set_position(int32_t x, int32_t y);
+
+        /**
+         * @brief Declare the surface fully opaque.
+         *
+         * Opaque surfaces use XRGB8888 buffers and set an opaque region, so the
+         * compositor can skip blending and cull whatever is behind them.
+         */
+        void set_opaque(bool opaque);
+
+        /**
+         * @brief Record presentation feedback for every commit into timeline.
+         * Only meaningful for root surfaces; synchronized subsurfaces present with their parent.
+         * @param timeline Must outlive the surface; nullptr stops recording.
+         */
+        void set_frame_timeline(FrameTimeline *timeline) { frame_timeline = timeline; }
+
+        /**
+         * @brief Allow the compositor to present commits immediately, at the cost of tearing.
+         * Ignored when wp_tearing_control_v1 is not available.
+         */
+        void set_tearing(bool allow);
+
+        /**
+         * @brief Make every commit wait until the previous one has been presented (wp_fifo_v1).
+         * @return False if the compositor does not support it.
+         */
+        bool set_fifo(bool enable);
+
+        /**
+         * @brief Make the next commit neither wait for nor place a FIFO barrier, e.g. for a
+         *        configure ack that must not be held back behind the previous frame.
+         */
+        void skip_fifo_barrier() { skip_barrier = true; }
+
+        /**
+         * @brief Ask the compositor not to present the next commit before time_ns, in the
+         *        presentation clock (wp_commit_timing_v1). Ignored when not supported.
+         */
+        void set_target_presentation_time(uint64_t time_ns);
+
+        /**
+         * @brief Show a single colour using a 1x1 single-pixel buffer scaled by a viewport.
+         *
+         * Releases the SHM swapchain, so no pixel memory is used at all. Requires the
+         * wp_single_pixel_buffer_manager_v1 and wp_viewporter globals.
+         * @param colour Premultiplied ARGB colour.
+         * @return False if either global is missing; the surface keeps its SHM buffers.
+         */
+        bool set_solid_colour(uint32_t colour);
+
+        /**
+         * @brief Temporarily show clear_colour as a single-pixel buffer instead of painting.
+         *
+         * Meant for interactive resizes: the SHM swapchain is kept but not reallocated for
+         * every intermediate size, and is repainted in full once the placeholder is removed.
+         * @return False if single pixel buffers are not supported.
+         */
+        bool set_placeholder(bool enable);
+
+        /**
+         * @brief Release pixel memory the compositor no longer needs.
+         * The surface keeps showing its last frame; the next draw rebuilds the buffers.
+         */
+        void trim();
     
     protected:
+
+        /**
+         * @brief Update the opaque and input regions for the current size.
+         * Regions are double buffered and take effect on the next commit.
+         */
+        virtual void update_regions();
+
+        auto create_region() const -> WlRegionPtr;
+
+        /**
+         * @brief Paint a rectangle of the acquired buffer. The default fills it with clear_colour.
+         */
+        virtual void paint(const Rect& rect);
+
         WlSurfacePtr surface;
         WlSubSurfacePtr subsurface;
         SurfaceBufferPtr buffer;
+        WlBufferPtr solid_buffer;
+        WpViewportPtr viewport;
 
         uint32_t width;
         uint32_t height;
 
         uint32_t clear_colour = 0;
+        bool opaque = false;
+
+        DamageRegion pending_damage;
+        /**
+         * @brief Damage of the most recently committed frames, newest first, used to bring
+         *        older swapchain slots up to date.
+         */
+        std::array<DamageRegion, 3> damage_history;
 
         static const uint32_t DECORATIONS_BORDER_SIZE = 4;
         static const uint32_t DECORATIONS_TOPBAR_SIZE = 32;
@@ -47,27 +174,91 @@ namespace tobi_engine
 
     private:
         void create_subsurface(const WaylandSurface *parent);
+        DrawResult draw_solid();
+        bool create_solid_buffer(uint32_t colour);
+        void request_presentation_feedback();
+
+        struct PresentationFeedback
+        {
+            WaylandSurface *surface;
+            WpPresentationFeedbackPtr feedback;
+            uint64_t commit_time_ns;
+        };
+        static void feedback_sync_output(void *data, struct wp_presentation_feedback *feedback, wl_output *output);
+        static void feedback_presented(void *data, struct wp_presentation_feedback *feedback, uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                       uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags);
+        static void feedback_discarded(void *data, struct wp_presentation_feedback *feedback);
+        void finish_feedback(PresentationFeedback *feedback);
 
         WaylandClient *client;
+        wl_event_queue *event_queue;
+
+        FrameTimeline *frame_timeline = nullptr;
+        std::vector<std::unique_ptr<PresentationFeedback>> pending_feedback;
+
+        WpTearingControlPtr tearing_control;
+#if defined(TOBI_HAS_FIFO_V1)
+        WpFifoPtr fifo;
+#endif
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+        WpCommitTimerPtr commit_timer;
+#endif
+        uint64_t target_presentation_ns = 0;
+        bool skip_barrier = false;
     };
 
+    /**
+     * @class DecorationSurface
+     * @brief One strip of the client-side frame around a content surface.
+     *
+     * The frame is built from four strips (the title bar and three borders), each a
+     * subsurface of the content surface placed around it, so decoration buffers only
+     * cover the visible frame instead of the whole window.
+     */
     class DecorationSurface : public WaylandSurface 
     {
     public:
-        DecorationSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent = nullptr);
+        enum class Edge { Top, Left, Right, Bottom };
+
+        /**
+         * @param width Width of the content surface the frame surrounds.
+         * @param height Height of the content surface the frame surrounds.
+         */
+        DecorationSurface(Edge edge, uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent);
         Type get_type() const override { return Type::Decoration; }
-        // Decoration-specific members...
+        Edge get_edge() const { return edge; }
 
+        /**
+         * @brief Resize the strip for a content surface of width x height.
+         */
         virtual void resize(uint32_t width, uint32_t height) override;
 
+        /**
+         * @brief Position and size of a strip relative to a width x height content surface.
+         */
+        static constexpr Rect geometry(Edge edge, uint32_t width, uint32_t height)
+        {
+            const auto border = int32_t(DECORATIONS_BORDER_SIZE);
+            const auto topbar = int32_t(DECORATIONS_TOPBAR_SIZE);
+            switch (edge)
+            {
+                case Edge::Top:    return { -border, -topbar, int32_t(width) + border * 2, topbar };
+                case Edge::Left:   return { -border, 0, border, int32_t(height) };
+                case Edge::Right:  return { int32_t(width), 0, border, int32_t(height) };
+                case Edge::Bottom: return { -border, int32_t(height), int32_t(width) + border * 2, border };
+            }
+            return {};
+        }
+
     private:
-        
+
+        Edge edge;
     };
 
     class ContentSurface : public WaylandSurface 
     {
     public:
-        ContentSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent = nullptr);
+        ContentSurface(uint32_t width, uint32_t height, WaylandClient *client, const WaylandSurface *parent = nullptr, wl_event_queue *queue = nullptr);
         Type get_type() const override { return Type::Content; }
         // Decoration-specific members...
 
@@ -1,123 +1,304 @@
 #include "wayland_surface_buffer.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <format>
+#include <memory>
 #include <stdexcept>
 #include <string>
-#include <sys/mman.h>
-#include <unistd.h>
 #include <wayland-client-protocol.h>
 
 #include "utils/logger.hpp"
-#include "utils/utils.hpp"
+#include "utils/pixel_kernels.hpp"
 #include "wayland_client.hpp"
 
 
 namespace tobi_engine
 {
 
-    SurfaceBuffer::SurfaceBuffer(uint32_t width, uint32_t height, WaylandClient *client) 
-        :   file_descriptor(-1),
+    namespace
+    {
+        constexpr uint32_t slot_count_for(PresentMode mode)
+        {
+            switch (mode)
+            {
+                case PresentMode::DropIfBusy:
+                    return 2;
+                case PresentMode::Fifo:
+                case PresentMode::Mailbox:
+                default:
+                    return 3;
+            }
+        }
+    }
+
+    SurfaceBuffer::SurfaceBuffer(uint32_t width, uint32_t height, WaylandClient *client, PresentMode mode, wl_event_queue *queue)
+        :   client(client),
+            arena(client->get_shm_arena()),
+            queue(queue),
             width(width),
             height(height),
-            size(height * width * PIXEL_SIZE),
-            memory(nullptr),
-            client(client)
+            present_mode(mode),
+            slot_count(slot_count_for(mode))
     {
-        LOG_DEBUG("width = {}, height = {}", width, height);
-        initialize();
+        LOG_DEBUG("width = {}, height = {}, slots = {}", width, height, slot_count);
+        if (!arena)
+            throw std::runtime_error("Failed to get Wayland SHM arena");
     }
 
-    SurfaceBuffer::~SurfaceBuffer() 
-    { 
-        munmap(memory, size);
-        close(file_descriptor);
+    SurfaceBuffer::~SurfaceBuffer()
+    {
+        release();
     }
 
-    void SurfaceBuffer::initialize()
+    void SurfaceBuffer::release()
     {
-        allocate_shm();
-        create_shared_memory();
-        create_buffer();
+        for (auto& slot : slots)
+        {
+            if (slot.busy && slot.buffer)
+            {
+                // The compositor may still be reading the slot, so its block stays reserved
+                // until wl_buffer.release, which can arrive after this swapchain is gone.
+                auto block = slot.block;
+                auto retired = std::make_shared<Slot>(std::move(slot));
+                retired->owner = nullptr;
+                retired->arena = arena;
+                auto buffer = retired->buffer.get();
+                // The window's queue may be destroyed before the release; the default queue is not.
+                wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(buffer), nullptr);
+                wl_buffer_set_user_data(buffer, retired.get());
+                arena->retire(buffer, block, std::move(retired));
+            }
+            else
+            {
+                arena->free(slot.block);
+            }
+            slot = Slot{};
+        }
+
+        acquired = false;
+        current = 0;
     }
 
-    int32_t SurfaceBuffer::get_fd() const
-    { 
-        return file_descriptor; 
+    bool SurfaceBuffer::acquire()
+    {
+        if (acquired)
+            return true;
+
+        // Drawing resumed, so slots released from now on are needed again.
+        for (auto& slot : slots)
+            slot.trim_on_release = false;
+
+        if (present_mode == PresentMode::Fifo)
+        {
+            // Strict submission order: the next slot is the one presented the longest ago.
+            auto next = (current + 1) % slot_count;
+            if (slots[next].busy || !prepare_slot(slots[next]))
+                return false;
+            current = next;
+            acquired = true;
+            return true;
+        }
+
+        // Mailbox and DropIfBusy take any free slot, preferring the most recently presented:
+        // its contents are the youngest, so the least has to be repainted, and slots that
+        // were never needed are never allocated.
+        auto candidate = slot_count;
+        for (uint32_t i = 0; i < slot_count; ++i)
+        {
+            if (slots[i].busy)
+                continue;
+            if (candidate == slot_count || slots[i].presented_frame > slots[candidate].presented_frame)
+                candidate = i;
+        }
+
+        if (candidate == slot_count || !prepare_slot(slots[candidate]))
+            return false;
+
+        current = candidate;
+        acquired = true;
+        return true;
     }
 
-    void SurfaceBuffer::resize(uint32_t width, uint32_t height) 
-    { 
-        LOG_DEBUG("width = {}, height = {}", width, height);
-        if(width == this->width && height == this->height) 
+    bool SurfaceBuffer::can_acquire() const
+    {
+        if (acquired)
+            return true;
+        if (present_mode == PresentMode::Fifo)
+            return !slots[(current + 1) % slot_count].busy;
+        return std::any_of(slots.begin(), slots.begin() + slot_count, [](const Slot& slot) { return !slot.busy; });
+    }
+
+    uint32_t SurfaceBuffer::get_age() const
+    {
+        const auto& slot = slots[current];
+        if (!acquired || slot.presented_frame == 0)
+            return 0;
+        return static_cast<uint32_t>(frame_counter - slot.presented_frame + 1);
+    }
+
+    wl_buffer* SurfaceBuffer::present()
+    {
+        auto& slot = slots[current];
+        slot.busy = true;
+        slot.presented_frame = ++frame_counter;
+        acquired = false;
+        return slot.buffer.get();
+    }
+
+    void SurfaceBuffer::buffer_release(void *data, wl_buffer *buffer)
+    {
+        auto slot = static_cast<Slot*>(data);
+        if (!slot->owner)
+        {
+            // Destroys the slot along with its buffer.
+            slot->arena->release_retired(buffer);
             return;
+        }
+        slot->busy = false;
+        if (slot->trim_on_release)
+            slot->owner->trim_slot(*slot);
+        slot->owner->release_waiters.resume_all();
+    }
 
-        munmap(memory, this->size);
-        close(file_descriptor);
-        
+    void SurfaceBuffer::trim()
+    {
+        if (acquired)
+            return;
+
+        // Busy slots may still be read by the compositor, so they wait for their release.
+        for (auto& slot : slots)
+        {
+            if (slot.busy)
+                slot.trim_on_release = true;
+            else if (slot.block)
+                trim_slot(slot);
+        }
+    }
+
+    void SurfaceBuffer::trim_slot(Slot& slot)
+    {
+        arena->discard(slot.block);
+        arena->free(slot.block);
+        slot = Slot{};
+    }
+
+    void SurfaceBuffer::resize(uint32_t width, uint32_t height)
+    {
+        LOG_DEBUG("width = {}, height = {}", width, height);
+        // Slots pick up the new size lazily in prepare_slot(), so busy buffers stay intact.
         this->width = width;
         this->height = height;
-        this->size = width * height * PIXEL_SIZE;
-        
-        allocate_shm();
-        create_shared_memory();
-        create_buffer();
+
+        if (acquired && !prepare_slot(slots[current]))
+            acquired = false;
+    }
+
+    void SurfaceBuffer::set_format(uint32_t format)
+    {
+        if (format == this->format)
+            return;
+
+        this->format = format;
+
+        if (acquired && !prepare_slot(slots[current]))
+            acquired = false;
     }
 
     void SurfaceBuffer::fill(uint8_t data)
     {
-        std::fill((uint8_t*)memory, (uint8_t*)memory + this->size, data);
+        auto target = reinterpret_cast<uint8_t*>(slot_memory(slots[current]));
+        std::fill(target, target + slot_size(), data);
     }
     void SurfaceBuffer::fill(uint32_t data)
     {
-        std::fill(memory, memory + height * width, data);
+        PixelKernels::get().fill(slot_memory(slots[current]), size_t(width) * height, data);
     }
 
-    void SurfaceBuffer::allocate_shm() 
+    void SurfaceBuffer::fill_rect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t colour)
     {
-        // create random filename
-        auto name = std::string("/window-handle-")
-            .append(generate_random_string(10));
+        if (x >= this->width || y >= this->height)
+            return;
+        width = std::min(width, this->width - x);
+        height = std::min(height, this->height - y);
 
-        LOG_DEBUG("Created SHM: {}", name);
+        tobi_engine::fill_rect(slot_memory(slots[current]), this->width, x, y, width, height, colour);
+    }
 
-        file_descriptor = memfd_create(name.c_str(), 0);
-        if(file_descriptor == -1)
-            throw std::runtime_error("Failed to open file " + name);
-        
-        shm_unlink(name.c_str());
+    void SurfaceBuffer::blit(const uint32_t* source, uint32_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+        if (x >= this->width || y >= this->height)
+            return;
+        width = std::min(width, this->width - x);
+        height = std::min(height, this->height - y);
 
-        if(ftruncate(file_descriptor, size) == -1)
-            throw std::runtime_error("Failed to truncate file " + name);
+        auto target = slot_memory(slots[current]) + size_t(y) * this->width + x;
+        tobi_engine::blit(target, this->width, source, stride, width, height);
     }
 
-    void SurfaceBuffer::create_shared_memory()
+    void SurfaceBuffer::blend(const uint32_t* source, uint32_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
     {
-        memory = static_cast<uint32_t*>(mmap(nullptr, size,
-                                                    PROT_READ | PROT_WRITE,
-                                                    MAP_SHARED, file_descriptor, 0));
-        if (memory == MAP_FAILED)
-        {
-            throw std::runtime_error("Failed to map shared memory.");
-        }
+        if (x >= this->width || y >= this->height)
+            return;
+        width = std::min(width, this->width - x);
+        height = std::min(height, this->height - y);
+
+        auto target = slot_memory(slots[current]) + size_t(y) * this->width + x;
+        blend_over(target, this->width, source, stride, width, height);
     }
 
-    void SurfaceBuffer::create_buffer()
+    bool SurfaceBuffer::prepare_slot(Slot& slot)
     {
-        auto shm = client->get_shm();
-        if (!shm)
+        if (slot.buffer && slot.width == width && slot.height == height && slot.format == format)
+            return true;
+
+        static constexpr wl_buffer_listener buffer_listener
+        {
+            &SurfaceBuffer::buffer_release
+        };
+
+        slot.buffer.reset();
+
+        // Only exchange the backing block when the new size outgrows its size class,
+        // or when it has shrunk so far that holding on to the old block is wasteful.
+        auto required = WaylandShmArena::size_class(slot_size());
+        if (slot.block.size < required || slot.block.size > required * SHRINK_FACTOR)
         {
-            throw std::runtime_error("Failed to get Wayland SHM");
+            arena->free(slot.block);
+            slot.block = {};
+            // Usually called from a listener, which an exception must not unwind through;
+            // the frame is dropped instead and the slot retried on the next acquire().
+            try
+            {
+                slot.block = arena->allocate(slot_size());
+            }
+            catch (const std::exception& e)
+            {
+                LOG_ERROR("Failed to allocate a {}x{} buffer: {}", width, height, e.what());
+                return false;
+            }
         }
-        wl_shm_pool* pool = wl_shm_create_pool(shm, file_descriptor, size);
-        if (!pool)
-            throw std::runtime_error("Failed to create Wayland SHM pool.");
-
-        buffer.reset(wl_shm_pool_create_buffer(pool, 0, width, height, width * PIXEL_SIZE, WL_SHM_FORMAT_ARGB8888));
-        wl_shm_pool_destroy(pool);
-        if (!buffer)
-            throw std::runtime_error("Failed to create Wayland buffer.");
+
+        slot.buffer.reset(arena->create_buffer(slot.block, width, height, width * PIXEL_SIZE, format));
+        if (!slot.buffer)
+        {
+            LOG_ERROR("Failed to create Wayland buffer.");
+            return false;
+        }
+        // Releases are dispatched with the rest of the owning window's events, so the
+        // busy flags are only touched by the thread that draws into the slots.
+        if (queue)
+            wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(slot.buffer.get()), queue);
+        wl_buffer_add_listener(slot.buffer.get(), &buffer_listener, &slot);
+
+        slot.width = width;
+        slot.height = height;
+        slot.format = format;
+        slot.owner = this;
+        // A new view (possibly with a new stride) leaves the contents undefined.
+        slot.presented_frame = 0;
+        return true;
     }
 }
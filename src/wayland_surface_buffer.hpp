@@ -1,45 +1,179 @@
 #pragma once
 
 #include "wayland_client.hpp"
+#include "wayland_shm_arena.hpp"
 #include "wayland_types.hpp"
+#include "async.hpp"
 
+#include <array>
+#include <coroutine>
 #include <cstdint>
 
 namespace tobi_engine
 {
 
+    /**
+     * @brief Policy used by SurfaceBuffer to pick the slot for the next frame.
+     *
+     * - Fifo: slots are cycled strictly in submission order. If the oldest slot is
+     *   still held by the compositor the frame is skipped instead of reordering.
+     * - Mailbox: any released slot may be reused, the most recently presented one first.
+     * - DropIfBusy: double buffered; when both slots are busy the frame is dropped.
+     *
+     * None of the modes block: acquire() fails instead of waiting on the compositor.
+     */
+    enum class PresentMode { Fifo, Mailbox, DropIfBusy };
+
+    /**
+     * @class SurfaceBuffer
+     * @brief Small swapchain of wl_shm buffers backing a single surface.
+     *
+     * Each slot is a wl_buffer over its own block of the connection's WaylandShmArena. A slot
+     * is marked busy once it is presented and becomes free again on wl_buffer.release,
+     * so drawing never touches memory the compositor may still be reading.
+     *
+     * Slot memory is allocated in arena size classes. Resizing only records the new
+     * size; when a slot is next acquired its wl_buffer is recreated as a view with the
+     * new dimensions over the existing block, and the block is only exchanged when the
+     * new size outgrows its capacity.
+     */
     class SurfaceBuffer
     {
         public:
-        
-            SurfaceBuffer(uint32_t width, uint32_t height, WaylandClient *client);
+
+            /**
+             * @param queue Event queue for wl_buffer.release, nullptr for the default queue.
+             */
+            SurfaceBuffer(uint32_t width, uint32_t height, WaylandClient *client, PresentMode mode = PresentMode::Mailbox, wl_event_queue *queue = nullptr);
             ~SurfaceBuffer();
 
-            int32_t get_fd() const;
-            wl_buffer* get_buffer() const { return buffer.get(); }
+            SurfaceBuffer(const SurfaceBuffer&) = delete;
+            SurfaceBuffer& operator=(const SurfaceBuffer&) = delete;
+
+            /**
+             * @brief Get the wl_buffer of the current slot (acquired or last presented).
+             */
+            wl_buffer* get_buffer() const { return slots[current].buffer.get(); }
             uint32_t get_width() const { return width; }
             uint32_t get_height() const { return height; }
+            PresentMode get_present_mode() const { return present_mode; }
+            uint32_t get_format() const { return format; }
+            /**
+             * @brief Age of the acquired slot's contents in frames.
+             * @return 0 if the contents are undefined, 1 if they hold the last presented
+             *         frame, n if they are n frames old.
+             */
+            uint32_t get_age() const;
+
+            /**
+             * @brief Pick a slot that is not held by the compositor to draw into.
+             * @return False if no slot is free under the current present mode, or its
+             *         memory could not be allocated.
+             */
+            [[nodiscard]] bool acquire();
+            /**
+             * @brief Whether acquire() would succeed right now.
+             */
+            bool can_acquire() const;
+
+            struct ReleaseAwaiter
+            {
+                SurfaceBuffer& buffer;
+                bool await_ready() const { return buffer.can_acquire(); }
+                void await_suspend(std::coroutine_handle<> handle) { buffer.release_waiters.add(handle); }
+                void await_resume() const noexcept {}
+            };
+
+            /**
+             * @brief Awaitable resumed once the compositor released a slot that acquire() can
+             *        take; ready right away when one is free already.
+             */
+            auto released() -> ReleaseAwaiter { return { *this }; }
+
+            /**
+             * @brief Mark the acquired slot as held by the compositor.
+             * @return The wl_buffer to attach to the surface.
+             */
+            wl_buffer* present();
+
+            /**
+             * @brief Return the memory of every slot the compositor is not holding, and of the
+             *        others as soon as they are released, unless a slot is acquired before.
+             * Trimmed slots are recreated by acquire() and start with undefined contents.
+             */
+            void trim();
 
             void resize(uint32_t width, uint32_t height);
+            /**
+             * @brief Change the wl_shm format; slots are re-created lazily like on resize.
+             */
+            void set_format(uint32_t format);
             void fill(uint8_t data);
             void fill(uint32_t data);
+            /**
+             * @brief Fill a rectangle of the acquired slot, clipped to the buffer.
+             */
+            void fill_rect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t colour);
+            /**
+             * @brief Copy premultiplied pixels into the acquired slot, clipped to the buffer.
+             * @param stride Row pitch of the source in pixels.
+             */
+            void blit(const uint32_t* source, uint32_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+            /**
+             * @brief Composite premultiplied pixels over the acquired slot, clipped to the buffer.
+             * @param stride Row pitch of the source in pixels.
+             */
+            void blend(const uint32_t* source, uint32_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 
         private:
-            
-            void initialize();
-            void allocate_shm();
-            void create_shared_memory();
-            void create_buffer();
+
+            struct Slot
+            {
+                WlBufferPtr buffer;
+                ShmBlock block;
+                uint32_t width = 0;
+                uint32_t height = 0;
+                uint32_t format = WL_SHM_FORMAT_ARGB8888;
+                uint64_t presented_frame = 0;
+                bool busy = false;
+                /** @brief Trim the slot once the compositor releases it. */
+                bool trim_on_release = false;
+                /** @brief Null once the slot was retired to the arena with its swapchain gone. */
+                SurfaceBuffer *owner = nullptr;
+                WaylandShmArena *arena = nullptr;
+            };
+
+            static void buffer_release(void *data, wl_buffer *buffer);
+
+            void release();
+            void trim_slot(Slot& slot);
+            /**
+             * @brief (Re)create the slot's buffer for the current size and format.
+             * @return False if the arena could not provide the memory.
+             */
+            bool prepare_slot(Slot& slot);
+
+            auto slot_size() const -> uint32_t { return width * height * PIXEL_SIZE; }
+            auto slot_memory(const Slot& slot) const -> uint32_t* { return reinterpret_cast<uint32_t*>(arena->data(slot.block)); }
 
             WaylandClient *client;
-            
-            int32_t file_descriptor;
+            WaylandShmArena *arena;
+            wl_event_queue *queue;
+
             uint32_t width;
             uint32_t height;
-            uint32_t size;
-            uint32_t* memory;
-            WlBufferPtr buffer;
+            uint32_t format = WL_SHM_FORMAT_ARGB8888;
+
+            PresentMode present_mode;
+            uint32_t slot_count;
+            uint32_t current = 0;
+            bool acquired = false;
+            uint64_t frame_counter = 0;
+            std::array<Slot, 3> slots;
+            WaiterList release_waiters;
+
             static constexpr uint32_t PIXEL_SIZE = sizeof(uint32_t);
+            static constexpr uint32_t SHRINK_FACTOR = 4;
     };
 
 }
@@ -1,11 +1,26 @@
 #pragma once
 
 #include <memory>
+#include <tuple>
 
 #include <wayland-client-core.h>
 #include <wayland-client-protocol.h>
 #include <wayland-cursor.h>
 #include <wayland-xdg-shell-client-protocol.h>
+#include <wayland-single-pixel-buffer-v1-client-protocol.h>
+#include <wayland-viewporter-client-protocol.h>
+#include <wayland-xdg-decoration-unstable-v1-client-protocol.h>
+#include <wayland-presentation-time-client-protocol.h>
+#include <wayland-tearing-control-v1-client-protocol.h>
+#if defined(TOBI_HAS_FIFO_V1)
+#include <wayland-fifo-v1-client-protocol.h>
+#endif
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+#include <wayland-commit-timing-v1-client-protocol.h>
+#endif
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+#include <wayland-cursor-shape-v1-client-protocol.h>
+#endif
 #include <xkbcommon/xkbcommon.h>
 
 namespace tobi_engine
@@ -42,7 +57,70 @@ namespace tobi_engine
     { 
         static constexpr const char* interface_name = "wl_seat";
         static constexpr const wl_interface* interface = &wl_seat_interface;
-        static constexpr uint32_t version = 4; // only supporting version 4 for now
+        // Every wl_pointer event the headers know of is handled, so bind as far as they go.
+#if defined(WL_POINTER_AXIS_RELATIVE_DIRECTION_SINCE_VERSION)
+        static constexpr uint32_t version = 9;
+#elif defined(WL_POINTER_AXIS_VALUE120_SINCE_VERSION)
+        static constexpr uint32_t version = 8;
+#else
+        static constexpr uint32_t version = 7;
+#endif
+    };
+
+    // Optional protocols, bound only when the compositor advertises them
+    template<> struct WaylandInterfaceTraits<wp_single_pixel_buffer_manager_v1>
+    {
+        static constexpr const char* interface_name = "wp_single_pixel_buffer_manager_v1";
+        static constexpr const wl_interface* interface = &wp_single_pixel_buffer_manager_v1_interface;
+        static constexpr uint32_t version = 1;
+    };
+    template<> struct WaylandInterfaceTraits<wp_viewporter>
+    {
+        static constexpr const char* interface_name = "wp_viewporter";
+        static constexpr const wl_interface* interface = &wp_viewporter_interface;
+        static constexpr uint32_t version = 1;
+    };
+    template<> struct WaylandInterfaceTraits<wp_presentation>
+    {
+        static constexpr const char* interface_name = "wp_presentation";
+        static constexpr const wl_interface* interface = &wp_presentation_interface;
+        static constexpr uint32_t version = 1;
+    };
+    template<> struct WaylandInterfaceTraits<wp_tearing_control_manager_v1>
+    {
+        static constexpr const char* interface_name = "wp_tearing_control_manager_v1";
+        static constexpr const wl_interface* interface = &wp_tearing_control_manager_v1_interface;
+        static constexpr uint32_t version = 1;
+    };
+#if defined(TOBI_HAS_FIFO_V1)
+    template<> struct WaylandInterfaceTraits<wp_fifo_manager_v1>
+    {
+        static constexpr const char* interface_name = "wp_fifo_manager_v1";
+        static constexpr const wl_interface* interface = &wp_fifo_manager_v1_interface;
+        static constexpr uint32_t version = 1;
+    };
+#endif
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+    template<> struct WaylandInterfaceTraits<wp_commit_timing_manager_v1>
+    {
+        static constexpr const char* interface_name = "wp_commit_timing_manager_v1";
+        static constexpr const wl_interface* interface = &wp_commit_timing_manager_v1_interface;
+        static constexpr uint32_t version = 1;
+    };
+#endif
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+    template<> struct WaylandInterfaceTraits<wp_cursor_shape_manager_v1>
+    {
+        static constexpr const char* interface_name = "wp_cursor_shape_manager_v1";
+        static constexpr const wl_interface* interface = &wp_cursor_shape_manager_v1_interface;
+        static constexpr uint32_t version = 1;
+    };
+#endif
+    template<> struct WaylandInterfaceTraits<zxdg_decoration_manager_v1>
+    {
+        static constexpr const char* interface_name = "zxdg_decoration_manager_v1";
+        static constexpr const wl_interface* interface = &zxdg_decoration_manager_v1_interface;
+        static constexpr uint32_t version = 1;
     };
 
     // Templated unique pointer deleters for Wayland proxy objects
@@ -70,6 +148,45 @@ namespace tobi_engine
             WlUniquePtr<wl_seat>
         >;
 
+    using OptionalProtocols =
+        std::tuple<
+            WlUniquePtr<wp_single_pixel_buffer_manager_v1>,
+            WlUniquePtr<wp_viewporter>,
+            WlUniquePtr<zxdg_decoration_manager_v1>,
+            WlUniquePtr<wp_presentation>,
+            WlUniquePtr<wp_tearing_control_manager_v1>
+#if defined(TOBI_HAS_FIFO_V1)
+            , WlUniquePtr<wp_fifo_manager_v1>
+#endif
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+            , WlUniquePtr<wp_commit_timing_manager_v1>
+#endif
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+            , WlUniquePtr<wp_cursor_shape_manager_v1>
+#endif
+        >;
+
+    /**
+     * @brief Owns a proxy wrapper created with wl_proxy_create_wrapper().
+     */
+    struct WlProxyWrapperDeleter { void operator()(void* ptr) const noexcept { if (ptr) wl_proxy_wrapper_destroy(ptr); } };
+    template <typename T>
+    using WlProxyWrapperPtr = std::unique_ptr<T, WlProxyWrapperDeleter>;
+
+    /**
+     * @brief Wrap a proxy so that objects created through the wrapper are assigned to queue
+     *        from the start, with no window in which their events land on another queue.
+     * @param queue Target queue; nullptr selects the default queue.
+     */
+    template <typename T>
+    auto create_queue_wrapper(T* proxy, wl_event_queue* queue) -> WlProxyWrapperPtr<T>
+    {
+        auto wrapper = static_cast<T*>(wl_proxy_create_wrapper(proxy));
+        if (wrapper)
+            wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(wrapper), queue);
+        return WlProxyWrapperPtr<T>(wrapper);
+    }
+
     using WlCompositorPtr = WlUniquePtr<wl_compositor>;
     using WlSubCompositorPtr = WlUniquePtr<wl_subcompositor>;
     using WlShmPtr = WlUniquePtr<wl_shm>;
@@ -86,22 +203,48 @@ namespace tobi_engine
     using  WlCursorThemePtr = std::unique_ptr<wl_cursor_theme, WlCursorThemeDeleter>;
     struct WlDisplayDeleter { void operator()(wl_display* ptr) const noexcept { if (ptr) { wl_display_flush(ptr); wl_display_disconnect(ptr); } } };
     using  WlDisplayPtr = std::unique_ptr<wl_display, WlDisplayDeleter>;
+    struct WlEventQueueDeleter { void operator()(wl_event_queue* ptr) const noexcept { if (ptr) wl_event_queue_destroy(ptr); } };
+    using  WlEventQueuePtr = std::unique_ptr<wl_event_queue, WlEventQueueDeleter>;
     struct WlKeyboardDeleter { void operator()(wl_keyboard* ptr) const noexcept { if (ptr) wl_keyboard_destroy(ptr); } };
     using  WlKeyboardPtr = std::unique_ptr<wl_keyboard, WlKeyboardDeleter>;
     struct WlPointerDeleter { void operator()(wl_pointer* ptr) const noexcept { if (ptr) wl_pointer_destroy(ptr); } };
     using  WlPointerPtr = std::unique_ptr<wl_pointer, WlPointerDeleter>;
+    struct WlRegionDeleter { void operator()(wl_region* ptr) const noexcept { if (ptr) wl_region_destroy(ptr); } };
+    using  WlRegionPtr = std::unique_ptr<wl_region, WlRegionDeleter>;
     struct WlRegistryDeleter { void operator()(wl_registry* ptr) const noexcept { if (ptr) wl_registry_destroy(ptr); } };
     using  WlRegistryPtr = std::unique_ptr<wl_registry, WlRegistryDeleter>;
+    struct WlShmPoolDeleter { void operator()(wl_shm_pool* ptr) const noexcept { if (ptr) wl_shm_pool_destroy(ptr); } };
+    using  WlShmPoolPtr = std::unique_ptr<wl_shm_pool, WlShmPoolDeleter>;
     struct WlSubSurfaceDeleter { void operator()(wl_subsurface* ptr) const noexcept { if (ptr) wl_subsurface_destroy(ptr); }; };
     using  WlSubSurfacePtr = std::unique_ptr<wl_subsurface, WlSubSurfaceDeleter>;
     struct WlSurfaceDeleter { void operator()(wl_surface* ptr) const noexcept { if (ptr) wl_surface_destroy(ptr); } };
     using  WlSurfacePtr = std::unique_ptr<wl_surface, WlSurfaceDeleter>;
+#if defined(TOBI_HAS_COMMIT_TIMING_V1)
+    struct WpCommitTimerDeleter { void operator()(wp_commit_timer_v1* ptr) const noexcept { if (ptr) wp_commit_timer_v1_destroy(ptr); } };
+    using  WpCommitTimerPtr = std::unique_ptr<wp_commit_timer_v1, WpCommitTimerDeleter>;
+#endif
+#if defined(TOBI_HAS_CURSOR_SHAPE_V1)
+    struct WpCursorShapeDeviceDeleter { void operator()(wp_cursor_shape_device_v1* ptr) const noexcept { if (ptr) wp_cursor_shape_device_v1_destroy(ptr); } };
+    using  WpCursorShapeDevicePtr = std::unique_ptr<wp_cursor_shape_device_v1, WpCursorShapeDeviceDeleter>;
+#endif
+#if defined(TOBI_HAS_FIFO_V1)
+    struct WpFifoDeleter { void operator()(wp_fifo_v1* ptr) const noexcept { if (ptr) wp_fifo_v1_destroy(ptr); } };
+    using  WpFifoPtr = std::unique_ptr<wp_fifo_v1, WpFifoDeleter>;
+#endif
+    struct WpPresentationFeedbackDeleter { void operator()(struct wp_presentation_feedback* ptr) const noexcept { if (ptr) wp_presentation_feedback_destroy(ptr); } };
+    using  WpPresentationFeedbackPtr = std::unique_ptr<struct wp_presentation_feedback, WpPresentationFeedbackDeleter>;
+    struct WpTearingControlDeleter { void operator()(wp_tearing_control_v1* ptr) const noexcept { if (ptr) wp_tearing_control_v1_destroy(ptr); } };
+    using  WpTearingControlPtr = std::unique_ptr<wp_tearing_control_v1, WpTearingControlDeleter>;
+    struct WpViewportDeleter { void operator()(wp_viewport* ptr) const noexcept { if (ptr) wp_viewport_destroy(ptr); } };
+    using  WpViewportPtr = std::unique_ptr<wp_viewport, WpViewportDeleter>;
     
 
     struct XdgSurfaceDeleter { void operator()(xdg_surface* ptr) const noexcept { if (ptr) xdg_surface_destroy(ptr); }; };
     using  XdgSurfacePtr = std::unique_ptr<xdg_surface, XdgSurfaceDeleter>;
     struct XdgToplevelDeleter { void operator()(xdg_toplevel* ptr) const noexcept { if (ptr) xdg_toplevel_destroy(ptr); }; };
     using  XdgToplevelPtr = std::unique_ptr<xdg_toplevel, XdgToplevelDeleter>;
+    struct ZxdgToplevelDecorationDeleter { void operator()(zxdg_toplevel_decoration_v1* ptr) const noexcept { if (ptr) zxdg_toplevel_decoration_v1_destroy(ptr); }; };
+    using  ZxdgToplevelDecorationPtr = std::unique_ptr<zxdg_toplevel_decoration_v1, ZxdgToplevelDecorationDeleter>;
     
     struct XkbContextDeleter { void operator()(xkb_context* ptr) const noexcept { if (ptr) xkb_context_unref(ptr); } };
     using  XkbContextPtr = std::unique_ptr<xkb_context, XkbContextDeleter>;
@@ -11,11 +11,15 @@
 #include <wayland-cursor.h>
 #include <xkbcommon/xkbcommon.h>
 #include "wayland-xdg-shell-client-protocol.h"
+#include "wayland-xdg-decoration-unstable-v1-client-protocol.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <format>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <utility>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -35,10 +39,8 @@ namespace tobi_engine
 
             xdg_surface_ack_configure(xdg_surface, serial);
 
-            if(!window->is_configured()) 
-                return;
-
-            window->draw();
+            // The ack only takes effect with the next commit of the root surface.
+            window->on_configure();
         }
 
         const struct xdg_surface_listener xdg_surface_listener = 
@@ -46,18 +48,12 @@ namespace tobi_engine
             xdg_surface_configure
         };
 
-        // should remove when supporting resizing with decorations
         static void toplevel_configure(void *data, struct xdg_toplevel *toplevel, int32_t new_width, int32_t new_height, struct wl_array* states) 
         {
-            LOG_DEBUG("toplevel_configure()");
+            LOG_DEBUG("toplevel_configure() {}x{}", new_width, new_height);
 
             auto window = static_cast<WaylandWindow*>(data);
-
-            // No change
-            if(!new_height && !new_width) 
-                return;
-            
-            window->resize(new_width, new_height);
+            window->set_pending_configure(new_width, new_height, states);
         }
 
         static void toplevel_close(void* data, struct xdg_toplevel *toplevel) 
@@ -74,13 +70,12 @@ namespace tobi_engine
             if (width > 0 && height > 0) 
             {
                 LOG_DEBUG("recommended bounds = {}x{}", width, height);
-                // window->set_recommended_bounds(width, height);
             } 
             else 
             {
                 LOG_DEBUG("bounds unknown or not set");
-                // window->clear_recommended_bounds();
             }
+            window->set_pending_bounds(width, height);
         }
 
         static void toplevel_wm_capabilities(void *data, struct xdg_toplevel *xdg_toplevel, struct wl_array *capabilities)
@@ -96,16 +91,17 @@ namespace tobi_engine
             toplevel_wm_capabilities
         };
 
-        void surface_ready_callback(void* data, struct wl_callback* callback, uint32_t callback_data) 
+        static void toplevel_decoration_configure(void *data, struct zxdg_toplevel_decoration_v1 *decoration, uint32_t mode)
         {
+            LOG_DEBUG("toplevel_decoration_configure() mode = {}", mode);
+
             auto window = static_cast<WaylandWindow*>(data);
-            
-            window->set_callback(nullptr);
+            window->set_decoration_mode(mode);
         }
 
-        const struct wl_callback_listener surface_ready_callback_listener = 
+        const struct zxdg_toplevel_decoration_v1_listener toplevel_decoration_listener =
         {
-            surface_ready_callback
+            toplevel_decoration_configure
         };
 
     } // namespace
@@ -117,9 +113,44 @@ namespace tobi_engine
         WaylandClient* client
     )
         :   Window(properties),
-            client(client)
+            client(client),
+            event_queue(client->create_event_queue()),
+            frame_scheduler([this]() { draw(); }, frame_timeline, client->get_presentation_clock()),
+            tasks(this->properties.threaded_dispatch ? -1 : client->get_wakeup_fd()),
+            idle_trim(this->properties.idle_trim_timeout_ms)
     {
         initialize();
+
+        if (this->properties.threaded_dispatch)
+            start_dispatch_thread();
+    }
+
+    void WaylandWindow::start_dispatch_thread()
+    {
+        dispatch_thread = std::jthread([this](std::stop_token stop)
+        {
+            // The timeout bounds how long joining the thread can take.
+            while (!stop.stop_requested())
+            {
+                auto timeout = frame_scheduler.get_timeout_ms();
+                if (timeout < 0 || timeout > DISPATCH_THREAD_TIMEOUT_MS)
+                    timeout = DISPATCH_THREAD_TIMEOUT_MS;
+
+                if (!client->dispatch(timeout, event_queue.get(), tasks.get_fd()))
+                {
+                    close_window();
+                    return;
+                }
+                tasks.run();
+                frame_scheduler.update();
+                trim_if_idle();
+            }
+        });
+    }
+
+    bool WaylandWindow::is_foreign_thread() const
+    {
+        return dispatch_thread.joinable() && std::this_thread::get_id() != dispatch_thread.get_id();
     }
 
     void WaylandWindow::update_decoration_mode(bool enable)
@@ -129,61 +160,234 @@ namespace tobi_engine
 
         is_decorated = enable;
 
-        if (callback) callback.reset();
-        if (x_toplevel) x_toplevel.reset();
-        if (x_surface) x_surface.reset();
+        if (toplevel_decoration)
+        {
+            // Asking for client-side mode is how decorations are turned off: the compositor
+            // stops drawing them and no strips are created. The answer arrives as a configure.
+            zxdg_toplevel_decoration_v1_set_mode(toplevel_decoration.get(), enable
+                ? ZXDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE
+                : ZXDG_TOPLEVEL_DECORATION_V1_MODE_CLIENT_SIDE);
+            return;
+        }
 
-        // Destroy surfaces and buffers
-        surfaces.clear();
+        update_client_side_decorations();
+        if (configured)
+            draw(true);
+    }
 
-        client->flush();
-        client->clear();
+    void WaylandWindow::set_decoration_mode(uint32_t mode)
+    {
+        // Applied with the xdg_surface.configure that follows.
+        pending_configure.decoration_mode = mode;
+    }
 
-        // Re-initialize with the new decoration state
-        initialize();
+    void WaylandWindow::set_pending_configure(int32_t width, int32_t height, wl_array *states)
+    {
+        pending_configure.width = width;
+        pending_configure.height = height;
+
+        pending_configure.states.reset();
+        auto first = static_cast<const uint32_t*>(states->data);
+        for (auto state = first; state != first + states->size / sizeof(uint32_t); ++state)
+        {
+            // States from newer protocol versions are of no interest.
+            if (*state < pending_configure.states.size())
+                pending_configure.states.set(*state);
+        }
     }
 
-    void WaylandWindow::initialize()
+    void WaylandWindow::set_pending_bounds(int32_t width, int32_t height)
     {
-        cursor = std::make_unique<WaylandCursor>(client);
-        if (!cursor)
+        pending_configure.bounds_width = width;
+        pending_configure.bounds_height = height;
+        pending_configure.has_bounds = true;
+    }
+
+    void WaylandWindow::apply_pending_configure()
+    {
+        // Only the state announced last before xdg_surface.configure counts; everything
+        // sent in between was superseded without ever being shown.
+        auto pending = std::exchange(pending_configure, {});
+
+        if (pending.decoration_mode)
+            decoration_mode = *pending.decoration_mode;
+        if (pending.has_bounds)
         {
-            LOG_ERROR("Failed to create Wayland cursor");
-            throw std::runtime_error("Failed to create Wayland cursor");
+            bounds_width = pending.bounds_width;
+            bounds_height = pending.bounds_height;
         }
-        auto shell = client->get_shell();
-        if (!shell)
+        apply_toplevel_states(pending.states);
+        update_client_side_decorations();
+
+        const uint32_t frame_width = has_client_side_decorations() ? DECORATIONS_BORDER_SIZE * 2 : 0;
+        const uint32_t frame_height = has_client_side_decorations() ? DECORATIONS_BORDER_SIZE + DECORATIONS_TOPBAR_SIZE : 0;
+        auto width = this->properties.width + frame_width;
+        auto height = this->properties.height + frame_height;
+
+        // A zero dimension leaves the choice to the client; the first size picked should
+        // still fit the recommended bounds.
+        if (pending.width > 0)
+            width = pending.width;
+        else if (!configured && bounds_width > 0)
+            width = std::min(width, uint32_t(bounds_width));
+
+        if (pending.height > 0)
+            height = pending.height;
+        else if (!configured && bounds_height > 0)
+            height = std::min(height, uint32_t(bounds_height));
+
+        if (width != this->properties.width + frame_width || height != this->properties.height + frame_height)
+            resize(width, height);
+    }
+
+    void WaylandWindow::apply_toplevel_states(ToplevelStates states)
+    {
+        const auto changed = states ^ toplevel_states;
+        toplevel_states = states;
+
+        // Suspended windows are fully hidden; nothing is drawn until they are shown again.
+        if (changed.test(XDG_TOPLEVEL_STATE_SUSPENDED))
         {
-            LOG_ERROR("Failed to get shell");
-            throw std::runtime_error("Failed to get shell");
+            LOG_DEBUG("suspended = {}", has_state(XDG_TOPLEVEL_STATE_SUSPENDED));
+            frame_scheduler.set_suspended(has_state(XDG_TOPLEVEL_STATE_SUSPENDED));
+            if (has_state(XDG_TOPLEVEL_STATE_SUSPENDED))
+                trim();
         }
-        if(is_decorated)
+
+        // While the user drags the size, the content is only a placeholder, so the SHM
+        // buffers are not reallocated for every step; the real frame follows the resize.
+        if (changed.test(XDG_TOPLEVEL_STATE_RESIZING))
         {
-            surfaces.push_back(std::make_unique<DecorationSurface>(this->properties.width, this->properties.height, client));
-            surfaces.push_back(std::make_unique<ContentSurface>(this->properties.width, this->properties.height, client, surfaces[0].get()));
+            surfaces.front()->set_placeholder(has_state(XDG_TOPLEVEL_STATE_RESIZING));
+            // The intermediate sizes leave blocks of many classes behind in the bins.
+            if (!has_state(XDG_TOPLEVEL_STATE_RESIZING))
+                client->get_shm_arena()->flush_recycled();
+        }
+    }
 
-            set_callback(wl_surface_frame(surfaces[0]->get_surface()));
-            wl_callback_add_listener(callback.get(), &surface_ready_callback_listener, this);
+    void WaylandWindow::trim()
+    {
+        if (idle_trim.is_trimmed())
+            return;
 
+        LOG_DEBUG("Trimming window '{}'", properties.title);
+        for (auto &surface : surfaces)
+            surface->trim();
+        // Also returns what other windows left binned in the shared arena.
+        client->get_shm_arena()->trim();
+        idle_trim.mark_trimmed();
+    }
+
+    void WaylandWindow::trim_cursor()
+    {
+        if (!idle_trim.is_trimmed())
+        {
+            cursor_trimmed = false;
+            return;
+        }
+        // An animated cursor keeps its theme; retried until the animation ends.
+        if (cursor && !cursor_trimmed)
+            cursor_trimmed = cursor->trim();
+    }
 
-            x_surface.reset(xdg_wm_base_get_xdg_surface(shell, surfaces[0]->get_surface()));
-            xdg_surface_add_listener(x_surface.get(), &xdg_surface_listener, this);
+    void WaylandWindow::trim_if_idle()
+    {
+        if (idle_trim.get_timeout_ms() == 0)
+            trim();
+    }
 
-            wl_surface_set_user_data(surfaces[0]->get_surface(), this);
-            wl_surface_set_user_data(surfaces.back()->get_surface(), this);
+    void WaylandWindow::update_client_side_decorations()
+    {
+        // Fullscreen and maximized windows have no frame of their own.
+        const bool frameless = has_state(XDG_TOPLEVEL_STATE_FULLSCREEN) || has_state(XDG_TOPLEVEL_STATE_MAXIMIZED);
+        set_client_side_decorations(is_decorated && !frameless && decoration_mode == ZXDG_TOPLEVEL_DECORATION_V1_MODE_CLIENT_SIDE);
+    }
+
+    void WaylandWindow::set_client_side_decorations(bool enable)
+    {
+        if (enable == has_client_side_decorations())
+            return;
+
+        if (enable)
+        {
+            for (auto edge : { DecorationSurface::Edge::Top, DecorationSurface::Edge::Left,
+                               DecorationSurface::Edge::Right, DecorationSurface::Edge::Bottom })
+            {
+                surfaces.push_back(std::make_unique<DecorationSurface>(edge, this->properties.width, this->properties.height, client, surfaces.front().get()));
+                wl_surface_set_user_data(surfaces.back()->get_surface(), this);
+            }
         }
         else
         {
-            surfaces.push_back(std::make_unique<ContentSurface>(this->properties.width, this->properties.height, client));
+            // Destroying a subsurface would unmap it immediately, before the root commits
+            // the new geometry; retiring them keeps both changes in the same frame.
+            for (auto surface = std::next(surfaces.begin()); surface != surfaces.end(); ++surface)
+                retire(std::move(*surface));
+            surfaces.resize(1);
+        }
 
-            set_callback(wl_surface_frame(surfaces.back()->get_surface()));
-            wl_callback_add_listener(callback.get(), &surface_ready_callback_listener, this);
+        update_window_geometry();
+    }
 
-            x_surface.reset(xdg_wm_base_get_xdg_surface(shell, surfaces.back()->get_surface()));
-            xdg_surface_add_listener(x_surface.get(), &xdg_surface_listener, this);
+    void WaylandWindow::retire(std::shared_ptr<WaylandSurface> surface)
+    {
+        surface->unmap();
+        retired_surfaces.push_back(std::move(surface));
+    }
 
-            wl_surface_set_user_data(surfaces.back()->get_surface(), this);
+    void WaylandWindow::release_retired_surfaces()
+    {
+        static constexpr wl_callback_listener retirement_listener
+        {
+            &WaylandWindow::retirement_done
+        };
+
+        // Requests are processed in order, so once the sync is answered the compositor has
+        // applied the commit that hid these surfaces and they can be destroyed unseen.
+        auto display = create_queue_wrapper(client->get_display(), event_queue.get());
+        auto &retirement = retirements.emplace_back();
+        retirement.window = this;
+        retirement.surfaces.swap(retired_surfaces);
+        retirement.callback.reset(wl_display_sync(display.get()));
+        wl_callback_add_listener(retirement.callback.get(), &retirement_listener, &retirement);
+    }
+
+    void WaylandWindow::retirement_done(void *data, wl_callback *callback, uint32_t serial)
+    {
+        auto retirement = static_cast<Retirement*>(data);
+        retirement->window->retirements.remove_if([retirement](const Retirement& entry) { return &entry == retirement; });
+    }
+
+    bool WaylandWindow::has_client_side_decorations() const
+    {
+        return surfaces.size() > 1;
+    }
+
+    void WaylandWindow::initialize()
+    {
+        cursor = std::make_unique<WaylandCursor>(client);
+        if (!cursor)
+        {
+            LOG_ERROR("Failed to create Wayland cursor");
+            throw std::runtime_error("Failed to create Wayland cursor");
+        }
+        auto shell = client->get_shell();
+        if (!shell)
+        {
+            LOG_ERROR("Failed to get shell");
+            throw std::runtime_error("Failed to get shell");
         }
+        // The content surface is the xdg root; client-side decoration strips are subsurfaces
+        // placed around it, so the frame only needs buffers for what is visible.
+        surfaces.push_back(std::make_unique<ContentSurface>(this->properties.width, this->properties.height, client, nullptr, event_queue.get()));
+        wl_surface_set_user_data(surfaces.front()->get_surface(), this);
+        surfaces.front()->set_frame_timeline(&frame_timeline);
+        set_frame_pacing(properties.frame_pacing);
+
+        // The toplevel inherits the queue of the xdg_surface it is created from.
+        auto shell_wrapper = create_queue_wrapper(shell, event_queue.get());
+        x_surface.reset(xdg_wm_base_get_xdg_surface(shell_wrapper.get(), surfaces.front()->get_surface()));
+        xdg_surface_add_listener(x_surface.get(), &xdg_surface_listener, this);
 
         x_toplevel.reset(xdg_surface_get_toplevel(x_surface.get()));
         xdg_toplevel_set_title(x_toplevel.get(), properties.title.c_str());
@@ -192,18 +396,95 @@ namespace tobi_engine
             WINDOW_MINIMUM_SIZE + DECORATIONS_TOPBAR_SIZE + DECORATIONS_BORDER_SIZE);
         xdg_toplevel_set_app_id(x_toplevel.get(), properties.title.c_str());
         xdg_toplevel_add_listener(x_toplevel.get(), &toplevel_listener, this);
-        
-        draw();
+
+        // Prefer server-side decorations; the strips are only created if the compositor
+        // answers with client-side mode or cannot negotiate decorations at all.
+        if (auto decoration_manager = client->get_decoration_manager())
+        {
+            auto manager_wrapper = create_queue_wrapper(decoration_manager, event_queue.get());
+            toplevel_decoration.reset(zxdg_decoration_manager_v1_get_toplevel_decoration(manager_wrapper.get(), x_toplevel.get()));
+            zxdg_toplevel_decoration_v1_add_listener(toplevel_decoration.get(), &toplevel_decoration_listener, this);
+            zxdg_toplevel_decoration_v1_set_mode(toplevel_decoration.get(), is_decorated
+                ? ZXDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE
+                : ZXDG_TOPLEVEL_DECORATION_V1_MODE_CLIENT_SIDE);
+        }
+        else
+        {
+            update_client_side_decorations();
+        }
+        update_window_geometry();
+
+        // Attaching a buffer before the first configure is a protocol error, so the initial
+        // commit is empty; the configure it triggers draws the first frame.
+        surfaces.front()->commit();
     }
 
     void WaylandWindow::update()
     {
-        client->update();
+        // Pointer events are dispatched by the main loop, so the cursor animates there.
+        if (cursor)
+            cursor->update();
+
+        // With a dispatch thread, the thread owns the window's queue and deferred work.
+        if (!dispatch_thread.joinable())
+        {
+            // The main loop has read this window's events from the socket; dispatch them here.
+            if (!client->dispatch_pending(event_queue.get()))
+                close_window();
+
+            tasks.run();
+            frame_scheduler.update();
+            trim_if_idle();
+        }
+
+        trim_cursor();
+    }
+
+    auto WaylandWindow::clamp_dispatch_timeout(int timeout_ms) const -> int
+    {
+        auto earliest = [](int deadline, int other)
+        {
+            return other >= 0 && (deadline < 0 || other < deadline) ? other : deadline;
+        };
+
+        auto deadline = cursor ? cursor->get_timeout_ms() : -1;
+
+        // Threaded windows wake up on their own for everything but the cursor.
+        if (!dispatch_thread.joinable())
+        {
+            deadline = earliest(deadline, frame_scheduler.get_timeout_ms());
+            deadline = earliest(deadline, idle_trim.get_timeout_ms());
+        }
+        if (deadline < 0)
+            return timeout_ms;
+        if (timeout_ms < 0)
+            return deadline;
+        return std::min(timeout_ms, deadline);
+    }
+
+    void WaylandWindow::set_frame_pacing(FramePacing pacing)
+    {
+        if (is_foreign_thread())
+        {
+            post([this, pacing]() { set_frame_pacing(pacing); });
+            return;
+        }
+
+        properties.frame_pacing = pacing;
+
+        // Late latching is about latency, so let those frames tear in. Its commits are
+        // timed by the client rather than gated by frame callbacks, so FIFO barriers keep
+        // one from replacing a frame that was never shown; frame callback pacing commits
+        // once per frame already and would only wait on the barriers.
+        auto &root = surfaces.front();
+        root->set_tearing(pacing == FramePacing::LateLatch);
+        root->set_fifo(pacing == FramePacing::LateLatch);
+        frame_scheduler.set_pacing(pacing);
+    }
 
-        for (auto& action : pending_actions)
-            action();
-        
-        pending_actions.clear();
+    void WaylandWindow::post(TaskQueue::Task task)
+    {
+        tasks.post(std::move(task));
     }
 
     void WaylandWindow::on_key(uint32_t key, uint32_t state)
@@ -232,19 +513,19 @@ namespace tobi_engine
                     break;
                 case XKB_KEY_d:
                 case XKB_KEY_D:
-                    pending_actions.push_back([this]() { update_decoration_mode(true); } );
+                    post([this]() { update_decoration_mode(true); });
                     break;
                 case XKB_KEY_f:
                 case XKB_KEY_F: 
-                    pending_actions.push_back([this]() { update_decoration_mode(false); } );
+                    post([this]() { update_decoration_mode(false); });
                     break;
                 case XKB_KEY_a:
                 case XKB_KEY_A:
-                    xdg_toplevel_set_fullscreen(x_toplevel.get(), nullptr);
+                    post([this]() { xdg_toplevel_set_fullscreen(x_toplevel.get(), nullptr); });
                     break;
                 case XKB_KEY_s:
                 case XKB_KEY_S:
-                    xdg_toplevel_unset_fullscreen(x_toplevel.get());
+                    post([this]() { xdg_toplevel_unset_fullscreen(x_toplevel.get()); });
                     break;
             }
         }
@@ -259,15 +540,20 @@ namespace tobi_engine
     }
     void WaylandWindow::on_pointer_motion(int32_t x, int32_t y)
     {
-        LOG_DEBUG("Pointer moved to: ({}, {})", x, y);
-        
+        // Pointer events come from the main loop; the position belongs to the window's thread.
+        if (is_foreign_thread())
+        {
+            post([this, x, y]() { on_pointer_motion(x, y); });
+            return;
+        }
+
         pointer_position.x = x;
         pointer_position.y = y;
     }
 
     void WaylandWindow::resize(uint32_t width, uint32_t height)
     {
-        if(is_decorated)
+        if(has_client_side_decorations())
         {
             const auto decoration_width =  DECORATIONS_BORDER_SIZE * 2;
             const auto decoration_height = DECORATIONS_BORDER_SIZE + DECORATIONS_TOPBAR_SIZE;
@@ -281,21 +567,93 @@ namespace tobi_engine
             this->properties.height = std::max(height, WINDOW_MINIMUM_SIZE);
         }
 
+        update_window_geometry();
+
+        // Surfaces only record the new size; the draw after the configure ack commits it.
         for (auto &surface : surfaces)
-        {
             surface->resize(this->properties.width, this->properties.height);
+    }
+
+    void WaylandWindow::update_window_geometry()
+    {
+        if (!x_surface)
+            return;
+
+        // The frame lies outside the root surface, at negative offsets.
+        if (has_client_side_decorations())
+        {
+            xdg_surface_set_window_geometry(x_surface.get(),
+                -int32_t(DECORATIONS_BORDER_SIZE), -int32_t(DECORATIONS_TOPBAR_SIZE),
+                this->properties.width + DECORATIONS_BORDER_SIZE * 2,
+                this->properties.height + DECORATIONS_TOPBAR_SIZE + DECORATIONS_BORDER_SIZE);
+        }
+        else
+        {
+            xdg_surface_set_window_geometry(x_surface.get(), 0, 0, this->properties.width, this->properties.height);
         }
     }
 
-    void WaylandWindow::draw()
-    {   
-        for (auto surface : surfaces)
-            surface->draw();
+    void WaylandWindow::request_redraw()
+    {
+        // The scheduler belongs to whichever thread dispatches the window's queue.
+        if (is_foreign_thread())
+        {
+            post([this]() { request_redraw(); });
+            return;
+        }
+
+        // Without damage the draw would find nothing to repaint and skip the frame.
+        surfaces.front()->damage_all();
+        frame_scheduler.request_redraw();
     }
 
-    void WaylandWindow::set_callback(wl_callback *callback) 
+    auto WaylandWindow::get_frame_statistics() const -> FrameStatistics
     {
-        this->callback.reset(callback);
+        return frame_timeline.get_statistics();
+    }
+
+    void WaylandWindow::draw(bool force_commit)
+    {   
+        // Before the first configure the configure itself triggers the first draw.
+        if (!configured)
+            return;
+
+        // A suspended window is not visible; only configure acks still need a commit.
+        if (frame_scheduler.is_suspended() && !force_commit && !configure_pending)
+            return;
+
+        // Subsurfaces are synchronized: their commits are cached until the root commits,
+        // so the root goes last and commits whenever any of them did.
+        bool children_committed = false;
+        bool repainted = false;
+        for (auto surface = surfaces.rbegin(); surface != std::prev(surfaces.rend()); ++surface)
+        {
+            auto result = (*surface)->draw();
+            children_committed |= result != WaylandSurface::DrawResult::Skipped;
+            repainted |= result == WaylandSurface::DrawResult::Repainted;
+        }
+
+        // Coroutines waiting for a frame need a commit to carry the frame callback.
+        auto &root = surfaces.front();
+        const bool commit_root = force_commit || configure_pending || children_committed || root->has_damage() ||
+                                 !retired_surfaces.empty() || frame_scheduler.has_frame_waiters();
+        if (!commit_root)
+            return;
+
+        // The frame callback is double-buffered state and must precede the commit.
+        frame_scheduler.arm(root->get_surface());
+        if (auto target = frame_scheduler.get_target_presentation())
+            root->set_target_presentation_time(target);
+        // The compositor waits for configure acks; they must not queue behind a barrier.
+        if (force_commit || configure_pending)
+            root->skip_fifo_barrier();
+        repainted |= root->draw(true) == WaylandSurface::DrawResult::Repainted;
+        configure_pending = false;
+        // Configure acks of a suspended window commit without a buffer and keep it trimmed.
+        idle_trim.on_commit(repainted);
+
+        if (!retired_surfaces.empty())
+            release_retired_surfaces();
     }
 
     void WaylandWindow::close_window() 
@@ -310,12 +668,64 @@ namespace tobi_engine
 
     bool WaylandWindow::is_configured() 
     { 
-        return !surfaces.empty(); 
+        return configured; 
+    }
+
+    void WaylandWindow::on_configure()
+    {
+        apply_pending_configure();
+
+        if (!configured)
+        {
+            configured = true;
+            draw(true);
+            configure_waiters.resume_all();
+            return;
+        }
+
+        // The ack has to be committed, but that can wait for the next frame callback, so
+        // a burst of configures during an interactive resize costs one frame at most.
+        // Occluded windows may never get the callback, so the wait is bounded to one
+        // refresh interval. Suspended windows get no callbacks and commit the ack right away.
+        configure_pending = true;
+        if (frame_scheduler.is_suspended())
+            draw();
+        else
+            frame_scheduler.request_urgent_redraw();
+    }
+
+    void WaylandWindow::wait_for_frame(std::coroutine_handle<> handle)
+    {
+        // The waiter lists belong to the dispatching thread; the coroutine moves there.
+        if (is_foreign_thread())
+        {
+            post([this, handle]() { frame_scheduler.wait_for_frame(handle); });
+            return;
+        }
+
+        frame_scheduler.wait_for_frame(handle);
+    }
+
+    void WaylandWindow::wait_for_configure(std::coroutine_handle<> handle)
+    {
+        if (is_foreign_thread())
+        {
+            // The configure may have arrived before the task runs.
+            post([this, handle]()
+            {
+                configure_waiters.add(handle);
+                if (configured)
+                    configure_waiters.resume_all();
+            });
+            return;
+        }
+
+        configure_waiters.add(handle);
     }
 
     void WaylandWindow::update_cursor(const std::string &cursor_name) 
     {
-        if (cursor) cursor->set_cursor(cursor_name);
+        if (cursor) cursor->set_cursor(cursor_name, pointer_event.serial);
     }
 
 } // namespace tobi_engine
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "frame_scheduler.hpp"
+#include "frame_timeline.hpp"
+#include "idle_trim_timer.hpp"
+#include "task_queue.hpp"
 #include "wayland_client.hpp"
 #include "wayland_cursor.hpp"
 #include "wayland_types.hpp"
@@ -7,10 +11,16 @@
 #include "wayland_surface_buffer.hpp"
 #include "window.hpp"
 
+#include <atomic>
+#include <bitset>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace tobi_engine
@@ -31,6 +41,11 @@ namespace tobi_engine
         wl_pointer *pointer = nullptr;
     };
 
+    /**
+     * @brief xdg_toplevel states indexed by their xdg_toplevel_state value.
+     */
+    using ToplevelStates = std::bitset<16>;
+
     class WaylandWindow : public Window
     {
     public:
@@ -38,8 +53,6 @@ namespace tobi_engine
         WaylandWindow(const WindowProperties &properties, WaylandClient* client);
         virtual ~WaylandWindow() override = default;
 
-        void set_callback(wl_callback *callback);
-
         void resize(uint32_t width, uint32_t heigth);
 
         void close_window();
@@ -51,9 +64,47 @@ namespace tobi_engine
 
         virtual void on_pointer_motion(int32_t x, int32_t y) override;
 
-        bool is_configured();
-
-        void draw();
+        virtual bool is_configured() override;
+        void on_configure();
+
+        /**
+         * @brief Apply the decoration mode chosen by the compositor.
+         * @param mode A zxdg_toplevel_decoration_v1_mode value.
+         */
+        void set_decoration_mode(uint32_t mode);
+
+        /**
+         * @brief Buffer the state of an xdg_toplevel.configure until the xdg_surface.configure
+         *        that completes it, so only the latest of a burst of configures is applied.
+         */
+        void set_pending_configure(int32_t width, int32_t height, wl_array *states);
+        void set_pending_bounds(int32_t width, int32_t height);
+
+        /**
+         * @brief Whether the last applied configure included the state.
+         * @param state An xdg_toplevel_state value.
+         */
+        bool has_state(uint32_t state) const { return state < toplevel_states.size() && toplevel_states.test(state); }
+
+        /**
+         * @brief Draw the damaged surfaces and commit the window right away.
+         * Prefer request_redraw(), which waits for the compositor's next frame.
+         * @param force_commit Commit the root surface even without damage, e.g. to ack a configure.
+         */
+        void draw(bool force_commit = false);
+        virtual void request_redraw() override;
+        virtual auto get_frame_statistics() const -> FrameStatistics override;
+        virtual void set_frame_pacing(FramePacing pacing) override;
+
+        /**
+         * @brief Shorten a main loop timeout so it wakes up for this window's next scheduled draw or cursor frame.
+         */
+        auto clamp_dispatch_timeout(int timeout_ms) const -> int;
+
+        /**
+         * @brief Run a task on the thread that dispatches this window. Safe from any thread.
+         */
+        void post(TaskQueue::Task task);
 
         void update_cursor(const std::string &cursor_name);
 
@@ -64,22 +115,106 @@ namespace tobi_engine
         
         virtual void initialize() override;
         void update_decoration_mode(bool enable);
+        void start_dispatch_thread();
+        /**
+         * @brief Whether the caller has to post() to reach the thread dispatching the window.
+         */
+        bool is_foreign_thread() const;
+        void update_window_geometry();
+        void set_client_side_decorations(bool enable);
+        void update_client_side_decorations();
+        void apply_pending_configure();
+        void apply_toplevel_states(ToplevelStates states);
+
+        /**
+         * @brief Release the pixel memory of every surface; the cursor follows in trim_cursor().
+         * Everything is rebuilt lazily by the next frame that is drawn.
+         */
+        void trim();
+        void trim_if_idle();
+        /**
+         * @brief Release the cursor theme once the window is trimmed. The cursor belongs to
+         *        the main loop, which dispatches pointer events, so only that may call this.
+         */
+        void trim_cursor();
+
+        /**
+         * @brief Unmap a surface with the next root commit and destroy it once the
+         *        compositor has processed that commit.
+         */
+        void retire(std::shared_ptr<WaylandSurface> surface);
+        void release_retired_surfaces();
+        static void retirement_done(void *data, wl_callback *callback, uint32_t serial);
+        bool has_client_side_decorations() const;
 
         void create_buffer();
 
+        virtual void wait_for_frame(std::coroutine_handle<> handle) override;
+        virtual void wait_for_configure(std::coroutine_handle<> handle) override;
+
         WaylandClient* client;
 
         std::unique_ptr<WaylandCursor> cursor;
 
+        /**
+         * @brief Queue of every object owned by this window, so one slow window cannot
+         *        stall the events of the others. Declared first to outlive its proxies.
+         */
+        WlEventQueuePtr event_queue;
+
         std::vector<std::shared_ptr<WaylandSurface>> surfaces;
 
-        WlCallbackPtr callback;
+        struct Retirement
+        {
+            WaylandWindow *window = nullptr;
+            WlCallbackPtr callback;
+            std::vector<std::shared_ptr<WaylandSurface>> surfaces;
+        };
+        /** @brief Unmapped surfaces waiting for the root commit that hides them. */
+        std::vector<std::shared_ptr<WaylandSurface>> retired_surfaces;
+        /** @brief Committed retirements waiting for their wl_display.sync to complete. */
+        std::list<Retirement> retirements;
+
+        FrameTimeline frame_timeline;
+        FrameScheduler frame_scheduler;
         XdgSurfacePtr x_surface;
         XdgToplevelPtr x_toplevel;
-
-        std::vector<std::function<void()>> pending_actions;
-
-        bool is_closed = false;
+        ZxdgToplevelDecorationPtr toplevel_decoration;
+
+        /** @brief Toplevel state received since the last xdg_surface.configure. */
+        struct ToplevelConfigure
+        {
+            int32_t width = 0;
+            int32_t height = 0;
+            ToplevelStates states;
+            int32_t bounds_width = 0;
+            int32_t bounds_height = 0;
+            bool has_bounds = false;
+            std::optional<uint32_t> decoration_mode;
+        };
+        ToplevelConfigure pending_configure;
+        ToplevelStates toplevel_states;
+        /** @brief Last zxdg_toplevel_decoration_v1 mode; client-side without a decoration manager. */
+        uint32_t decoration_mode = ZXDG_TOPLEVEL_DECORATION_V1_MODE_CLIENT_SIDE;
+        int32_t bounds_width = 0;
+        int32_t bounds_height = 0;
+
+        /**
+         * @brief Work posted from other threads. Shares the client's wakeup eventfd unless
+         *        the window has a dispatch thread of its own.
+         */
+        TaskQueue tasks;
+
+        std::atomic<bool> is_closed = false;
+        /** @brief Written by the dispatching thread, read by awaiters on any thread. */
+        std::atomic<bool> configured = false;
+        /** @brief A configure was acked and still has to be committed. */
+        bool configure_pending = false;
+
+        WaiterList configure_waiters;
+
+        IdleTrimTimer idle_trim;
+        bool cursor_trimmed = false;
 
         const uint32_t DECORATIONS_BORDER_SIZE = 4;
         const uint32_t DECORATIONS_TOPBAR_SIZE = 32;
@@ -89,6 +224,11 @@ namespace tobi_engine
         Position pointer_position;
 
         bool is_decorated = true;
+
+        static constexpr int DISPATCH_THREAD_TIMEOUT_MS = 100;
+
+        // Declared last so the thread is joined before anything it uses is destroyed.
+        std::jthread dispatch_thread;
     
     };
 
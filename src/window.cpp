@@ -13,6 +13,14 @@ namespace tobi_engine
         LOG_DEBUG("Window created with UID: {}", uid);
     }
 
+    void Window::on_pointer_frame(const PointerFrame& frame)
+    {
+        if (frame.moved)
+            on_pointer_motion(static_cast<int32_t>(frame.x), static_cast<int32_t>(frame.y));
+        for (uint32_t i = 0; i < frame.button_count; ++i)
+            on_pointer_button(frame.buttons[i].button, frame.buttons[i].state);
+    }
+
     uint64_t Window::get_uid() 
     { 
         return uid;
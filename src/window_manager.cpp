@@ -1,5 +1,6 @@
 #include "window_manager.hpp"
 
+#include "async.hpp"
 #include "window_registry.hpp"
 #include "utils/logger.hpp"
 
@@ -18,4 +19,55 @@ namespace tobi_engine
         return window_registry->create_window(properties);
     }
 
+    bool WindowManager::dispatch(int timeout_ms)
+    {
+        return window_registry->dispatch(timeout_ms);
+    }
+
+    void WindowManager::update()
+    {
+        window_registry->update();
+        CoroutineExceptions::rethrow();
+    }
+
+    bool WindowManager::should_close() const
+    {
+        return window_registry->should_close();
+    }
+
+    int WindowManager::get_fd() const
+    {
+        return window_registry->get_fd();
+    }
+
+    int WindowManager::get_wakeup_fd() const
+    {
+        return window_registry->get_wakeup_fd();
+    }
+
+    int WindowManager::get_timeout_ms() const
+    {
+        return window_registry->get_timeout_ms();
+    }
+
+    short WindowManager::prepare_read()
+    {
+        return window_registry->prepare_read();
+    }
+
+    bool WindowManager::read_events()
+    {
+        return window_registry->read_events();
+    }
+
+    void WindowManager::cancel_read()
+    {
+        window_registry->cancel_read();
+    }
+
+    void WindowManager::post(std::function<void()> task)
+    {
+        window_registry->post(std::move(task));
+    }
+
 } // namespace tobi_engine
@@ -22,5 +22,71 @@ namespace tobi_engine
         
         return window;
     }
+
+    auto WindowRegistry::dispatch(int timeout_ms) -> bool
+    {
+        // Wake up in time for the earliest scheduled draw.
+        for (const auto& [uid, window] : windows)
+            timeout_ms = window->clamp_dispatch_timeout(timeout_ms);
+
+        return client->dispatch(timeout_ms, nullptr, client->get_wakeup_fd());
+    }
+
+    void WindowRegistry::update()
+    {
+        // The client's queue drains the shared wakeup eventfd, so it runs first.
+        client->run_tasks();
+
+        for (auto& [uid, window] : windows)
+            window->update();
+    }
+
+    auto WindowRegistry::get_fd() const -> int
+    {
+        return client->get_fd();
+    }
+
+    auto WindowRegistry::get_wakeup_fd() const -> int
+    {
+        return client->get_wakeup_fd();
+    }
+
+    auto WindowRegistry::get_timeout_ms() const -> int
+    {
+        int timeout_ms = -1;
+        for (const auto& [uid, window] : windows)
+            timeout_ms = window->clamp_dispatch_timeout(timeout_ms);
+        return timeout_ms;
+    }
+
+    auto WindowRegistry::prepare_read() -> short
+    {
+        return client->prepare_read();
+    }
+
+    auto WindowRegistry::read_events() -> bool
+    {
+        return client->read_events();
+    }
+
+    void WindowRegistry::cancel_read()
+    {
+        client->cancel_read();
+    }
+
+    void WindowRegistry::post(std::function<void()> task)
+    {
+        client->post(std::move(task));
+    }
+
+    auto WindowRegistry::should_close() const -> bool
+    {
+        for (const auto& [uid, window] : windows)
+        {
+            if (!window->should_close())
+                return false;
+        }
+        return true;
+    }
     
 } // namespace tobi_engine
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "wayland_client.hpp"
+#include "wayland_window.hpp"
 #include "window.hpp"
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
 
@@ -21,11 +23,23 @@ namespace tobi_engine
 
         auto create_window(const WindowProperties& properties) -> std::shared_ptr<Window>;
 
+        auto dispatch(int timeout_ms) -> bool;
+        void update();
+        auto should_close() const -> bool;
+
+        auto get_fd() const -> int;
+        auto get_wakeup_fd() const -> int;
+        auto get_timeout_ms() const -> int;
+        auto prepare_read() -> short;
+        auto read_events() -> bool;
+        void cancel_read();
+        void post(std::function<void()> task);
+
     private:
 
         std::unique_ptr<WaylandClient> client;
 
-        std::unordered_map<uint64_t, std::shared_ptr<Window>> windows;
+        std::unordered_map<uint64_t, std::shared_ptr<WaylandWindow>> windows;
 
     };
 
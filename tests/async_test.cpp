@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "async.hpp"
+
+#include <coroutine>
+#include <stdexcept>
+#include <vector>
+
+using tobi_engine::AsyncTask;
+using tobi_engine::CoroutineExceptions;
+using tobi_engine::WaiterList;
+
+namespace
+{
+    struct Event
+    {
+        WaiterList& waiters;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { waiters.add(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    AsyncTask count_events(WaiterList& waiters, int& count, int limit)
+    {
+        while (count < limit)
+        {
+            co_await Event{ waiters };
+            ++count;
+        }
+    }
+
+    AsyncTask fail_after_event(WaiterList& waiters)
+    {
+        co_await Event{ waiters };
+        throw std::runtime_error("failed");
+    }
+}
+
+TEST_CASE("AsyncTask coroutines are resumed by their WaiterList", "[async]") {
+    SECTION("Each event resumes a waiting coroutine exactly once") {
+        WaiterList waiters;
+        int count = 0;
+        count_events(waiters, count, 3);
+        REQUIRE(count == 0);
+        REQUIRE_FALSE(waiters.empty());
+
+        waiters.resume_all();
+        REQUIRE(count == 1);
+        waiters.resume_all();
+        waiters.resume_all();
+        REQUIRE(count == 3);
+        REQUIRE(waiters.empty());
+
+        waiters.resume_all();
+        REQUIRE(count == 3);
+    }
+    SECTION("Every waiting coroutine is resumed") {
+        WaiterList waiters;
+        std::vector<int> counts(4, 0);
+        for (auto& count : counts)
+            count_events(waiters, count, 1);
+
+        waiters.resume_all();
+        REQUIRE(counts == std::vector<int>(4, 1));
+        REQUIRE(waiters.empty());
+    }
+    SECTION("Coroutines still waiting are destroyed with the list") {
+        int count = 0;
+        {
+            WaiterList waiters;
+            count_events(waiters, count, 10);
+        }
+        REQUIRE(count == 0);
+    }
+    SECTION("Exceptions are parked instead of escaping resume_all") {
+        WaiterList waiters;
+        int count = 0;
+        fail_after_event(waiters);
+        count_events(waiters, count, 1);
+
+        REQUIRE_NOTHROW(waiters.resume_all());
+        REQUIRE(count == 1);
+        REQUIRE(waiters.empty());
+
+        REQUIRE_THROWS_AS(CoroutineExceptions::rethrow(), std::runtime_error);
+        REQUIRE_NOTHROW(CoroutineExceptions::rethrow());
+    }
+}
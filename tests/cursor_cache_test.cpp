@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cursor_cache.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using tobi_engine::CursorImageSet;
+
+namespace
+{
+    struct XcursorImage
+    {
+        uint32_t nominal_size;
+        uint32_t width;
+        uint32_t height;
+        uint32_t delay;
+        uint32_t colour;
+    };
+
+    void put_u32(std::vector<uint8_t>& data, uint32_t value)
+    {
+        for (int shift = 0; shift < 32; shift += 8)
+            data.push_back(static_cast<uint8_t>(value >> shift));
+    }
+
+    void write_xcursor(const std::filesystem::path& path, const std::vector<XcursorImage>& images)
+    {
+        std::vector<uint8_t> data;
+        put_u32(data, 0x72756358);
+        put_u32(data, 16);
+        put_u32(data, 0x10000);
+        put_u32(data, static_cast<uint32_t>(images.size()));
+
+        auto position = 16 + static_cast<uint32_t>(images.size()) * 12;
+        for (const auto& image : images)
+        {
+            put_u32(data, 0xfffd0002);
+            put_u32(data, image.nominal_size);
+            put_u32(data, position);
+            position += 36 + image.width * image.height * 4;
+        }
+        for (const auto& image : images)
+        {
+            for (auto value : { 36u, 0xfffd0002u, image.nominal_size, 1u, image.width, image.height, 1u, 2u, image.delay })
+                put_u32(data, value);
+            for (uint32_t i = 0; i < image.width * image.height; ++i)
+                put_u32(data, image.colour);
+        }
+
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+
+    auto read_pixel(const CursorImageSet& set, uint32_t image) -> uint32_t
+    {
+        auto pixels = set.get_pixels().subspan(set.get_images()[image].offset, 4);
+        return uint32_t(pixels[0]) | uint32_t(pixels[1]) << 8 | uint32_t(pixels[2]) << 16 | uint32_t(pixels[3]) << 24;
+    }
+
+    struct ThemeDirectory
+    {
+        std::filesystem::path root = std::filesystem::temp_directory_path() / ("tobi-cursor-test-" + std::to_string(getpid()));
+        std::filesystem::path cursors = root / "cursors";
+
+        ThemeDirectory()
+        {
+            std::filesystem::create_directories(cursors);
+            write_xcursor(cursors / "left_ptr", {
+                { 24, 4, 4, 0, 0xff000000 },
+                { 48, 8, 8, 0, 0xffffffff },
+            });
+            write_xcursor(cursors / "watch", {
+                { 24, 4, 4, 50, 0xff0000ff },
+                { 24, 4, 4, 70, 0xff00ff00 },
+            });
+            std::filesystem::create_symlink("left_ptr", cursors / "default");
+            std::ofstream(cursors / "broken") << "not a cursor";
+        }
+        ~ThemeDirectory() { std::filesystem::remove_all(root); }
+    };
+}
+
+TEST_CASE("CursorImageSet decodes Xcursor files and round-trips through the cache file", "[cursor_cache]") {
+    ThemeDirectory theme;
+
+    SECTION("Decoding picks the closest nominal size and shares images between aliases") {
+        auto set = CursorImageSet::decode({ theme.cursors }, 32);
+        REQUIRE(set.get_cursors().size() == 3);
+        REQUIRE(set.get_images().size() == 3);
+
+        for (const auto& cursor : set.get_cursors())
+        {
+            if (cursor.name == "watch")
+            {
+                REQUIRE(cursor.image_count == 2);
+                REQUIRE(set.get_images()[cursor.first_image].delay == 50);
+                REQUIRE(set.get_images()[cursor.first_image + 1].delay == 70);
+                REQUIRE(read_pixel(set, cursor.first_image + 1) == 0xff00ff00);
+            }
+            else
+            {
+                REQUIRE(cursor.image_count == 1);
+                REQUIRE(set.get_images()[cursor.first_image].width == 4);
+                REQUIRE(read_pixel(set, cursor.first_image) == 0xff000000);
+            }
+        }
+
+        auto large = CursorImageSet::decode({ theme.cursors }, 40);
+        REQUIRE(large.get_images().size() == 3);
+        REQUIRE(large.get_pixels().size() == (8 * 8 + 2 * 4 * 4) * 4);
+    }
+    SECTION("A written cache maps back only for the same size and theme time") {
+        auto set = CursorImageSet::decode({ theme.cursors }, 24);
+        auto path = theme.root / "cache" / "test-24.cache";
+        REQUIRE(set.write(path, 24, 1234));
+
+        auto mapped = CursorImageSet::map(path, 24, 1234);
+        REQUIRE(mapped);
+        REQUIRE(mapped->get_cursors().size() == set.get_cursors().size());
+        REQUIRE(mapped->get_images().size() == set.get_images().size());
+        REQUIRE(std::equal(mapped->get_pixels().begin(), mapped->get_pixels().end(),
+                           set.get_pixels().begin(), set.get_pixels().end()));
+        REQUIRE(mapped->get_cursors()[0].name == set.get_cursors()[0].name);
+
+        REQUIRE_FALSE(CursorImageSet::map(path, 24, 1235));
+        REQUIRE_FALSE(CursorImageSet::map(path, 32, 1234));
+        REQUIRE_FALSE(CursorImageSet::map(theme.root / "missing.cache", 24, 1234));
+    }
+    SECTION("A truncated cache file is rejected") {
+        auto set = CursorImageSet::decode({ theme.cursors }, 24);
+        auto path = theme.root / "truncated.cache";
+        REQUIRE(set.write(path, 24, 1));
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+        REQUIRE_FALSE(CursorImageSet::map(path, 24, 1));
+    }
+}
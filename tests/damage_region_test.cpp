@@ -0,0 +1,43 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "damage_region.hpp"
+
+using tobi_engine::DamageRegion;
+using tobi_engine::Rect;
+
+TEST_CASE("DamageRegion merges and bounds rectangles", "[damage_region]") {
+    SECTION("Empty rectangles are ignored") {
+        DamageRegion region;
+        region.add(Rect{ 10, 10, 0, 5 });
+        REQUIRE(region.empty());
+    }
+    SECTION("Contained rectangles are absorbed") {
+        DamageRegion region;
+        region.add(Rect{ 0, 0, 100, 100 });
+        region.add(Rect{ 10, 10, 20, 20 });
+        REQUIRE(region.rects().size() == 1);
+        REQUIRE(region.rects()[0] == Rect{ 0, 0, 100, 100 });
+    }
+    SECTION("Adjacent rectangles sharing an edge merge without waste") {
+        DamageRegion region;
+        region.add(Rect{ 0, 0, 50, 10 });
+        region.add(Rect{ 50, 0, 50, 10 });
+        REQUIRE(region.rects().size() == 1);
+        REQUIRE(region.rects()[0] == Rect{ 0, 0, 100, 10 });
+    }
+    SECTION("Distant rectangles stay separate") {
+        DamageRegion region;
+        region.add(Rect{ 0, 0, 10, 10 });
+        region.add(Rect{ 100, 100, 10, 10 });
+        REQUIRE(region.rects().size() == 2);
+        REQUIRE(region.bounds() == Rect{ 0, 0, 110, 110 });
+    }
+    SECTION("The rectangle count is capped") {
+        DamageRegion region;
+        for (int32_t i = 0; i < 32; ++i)
+            region.add(Rect{ i * 20, i * 20, 5, 5 });
+
+        REQUIRE(region.rects().size() <= DamageRegion::MAX_RECTS);
+        REQUIRE(region.bounds() == Rect{ 0, 0, 31 * 20 + 5, 31 * 20 + 5 });
+    }
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "frame_scheduler.hpp"
+#include "frame_timeline.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+using tobi_engine::FrameScheduler;
+using tobi_engine::FrameTimeline;
+
+namespace
+{
+    // Stands in for the compositor: arming records an outstanding callback and
+    // complete_frame() plays the wl_callback.done event.
+    class TestScheduler : public FrameScheduler
+    {
+    public:
+        explicit TestScheduler(const FrameTimeline& timeline)
+            : FrameScheduler([this]() { ++draws; arm(nullptr); }, timeline, CLOCK_MONOTONIC)
+        {
+        }
+
+        void complete_frame() { on_frame_done(0); }
+
+        int draws = 0;
+
+    protected:
+        void request_callback(wl_surface*) override {}
+    };
+}
+
+TEST_CASE("FrameScheduler paces redraws to frame callbacks", "[frame_scheduler]") {
+    FrameTimeline timeline;
+    TestScheduler scheduler(timeline);
+
+    SECTION("Without an outstanding callback the window is drawn right away") {
+        scheduler.request_redraw();
+        REQUIRE(scheduler.draws == 1);
+        REQUIRE(scheduler.is_waiting());
+    }
+    SECTION("Requests while a callback is outstanding collapse into one draw") {
+        scheduler.request_redraw();
+        scheduler.request_redraw();
+        scheduler.request_redraw();
+        scheduler.request_redraw();
+        REQUIRE(scheduler.draws == 1);
+        REQUIRE(scheduler.get_timeout_ms() == -1);
+
+        scheduler.complete_frame();
+        REQUIRE(scheduler.draws == 2);
+        scheduler.complete_frame();
+        REQUIRE(scheduler.draws == 2);
+        REQUIRE_FALSE(scheduler.is_waiting());
+    }
+    SECTION("Suspended windows do not draw until they are resumed") {
+        scheduler.set_suspended(true);
+        scheduler.request_redraw();
+        scheduler.request_urgent_redraw();
+        REQUIRE(scheduler.draws == 0);
+        REQUIRE(scheduler.get_timeout_ms() == -1);
+
+        scheduler.set_suspended(false);
+        REQUIRE(scheduler.draws == 1);
+    }
+}
+
+TEST_CASE("FrameScheduler bounds urgent redraws to one refresh interval", "[frame_scheduler]") {
+    FrameTimeline timeline;
+    TestScheduler scheduler(timeline);
+    scheduler.request_redraw();
+    REQUIRE(scheduler.draws == 1);
+
+    SECTION("Without presentation feedback the deadline assumes 60 Hz") {
+        scheduler.request_urgent_redraw();
+        REQUIRE(scheduler.draws == 1);
+        REQUIRE(scheduler.get_timeout_ms() >= 16);
+        REQUIRE(scheduler.get_timeout_ms() <= 17);
+    }
+    SECTION("The deadline follows the reported refresh interval") {
+        timeline.record_presented(1'000'000, 8'333'333, 0);
+        scheduler.request_urgent_redraw();
+        REQUIRE(scheduler.get_timeout_ms() >= 8);
+        REQUIRE(scheduler.get_timeout_ms() <= 9);
+    }
+    SECTION("The window is drawn once the deadline passes without a callback") {
+        scheduler.request_urgent_redraw();
+        scheduler.update();
+        REQUIRE(scheduler.draws == 1);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE(scheduler.get_timeout_ms() == 0);
+        scheduler.update();
+        REQUIRE(scheduler.draws == 2);
+        REQUIRE(scheduler.get_timeout_ms() == -1);
+
+        // The late callback finds nothing left to draw.
+        scheduler.complete_frame();
+        REQUIRE(scheduler.draws == 2);
+    }
+    SECTION("A callback before the deadline draws right away and cancels it") {
+        scheduler.request_urgent_redraw();
+        scheduler.complete_frame();
+        REQUIRE(scheduler.draws == 2);
+        REQUIRE(scheduler.get_timeout_ms() == -1);
+    }
+}
@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "frame_timeline.hpp"
+
+using tobi_engine::FrameTimeline;
+
+TEST_CASE("FrameTimeline reports latency percentiles over the recent frames", "[frame_timeline]") {
+    SECTION("Nothing recorded reports zeros") {
+        FrameTimeline timeline;
+        auto statistics = timeline.get_statistics();
+        REQUIRE(statistics.presented == 0);
+        REQUIRE(statistics.latency_p50_ms == 0.0);
+        REQUIRE(timeline.latency_percentile(99.0) == 0);
+    }
+    SECTION("Nearest-rank percentiles") {
+        FrameTimeline timeline;
+        for (uint64_t latency = 1; latency <= 100; ++latency)
+            timeline.record_presented(latency, 16'666'667, 0);
+
+        REQUIRE(timeline.latency_percentile(0.0) == 1);
+        REQUIRE(timeline.latency_percentile(50.0) == 50);
+        REQUIRE(timeline.latency_percentile(90.0) == 90);
+        REQUIRE(timeline.latency_percentile(100.0) == 100);
+    }
+    SECTION("Old frames fall out of the ring buffer, counts keep growing") {
+        FrameTimeline timeline;
+        for (size_t i = 0; i < FrameTimeline::CAPACITY; ++i)
+            timeline.record_presented(1'000'000'000, 0, 0);
+        for (size_t i = 0; i < FrameTimeline::CAPACITY; ++i)
+            timeline.record_presented(2'000'000, 8'333'333, 0);
+        timeline.record_discarded();
+
+        auto statistics = timeline.get_statistics();
+        REQUIRE(statistics.presented == FrameTimeline::CAPACITY * 2);
+        REQUIRE(statistics.discarded == 1);
+        REQUIRE(statistics.latency_max_ms == 2.0);
+        REQUIRE(statistics.refresh_interval_ms > 8.3);
+        REQUIRE(statistics.refresh_interval_ms < 8.4);
+        REQUIRE(timeline.get_refresh_ns() == 8'333'333);
+    }
+    SECTION("Presentation is predicted on the refresh grid") {
+        FrameTimeline timeline;
+        REQUIRE(timeline.predict_presentation(1'000) == 0);
+
+        timeline.record_presented(0, 10'000, 100'000);
+        REQUIRE(timeline.predict_presentation(50'000) == 110'000);
+        REQUIRE(timeline.predict_presentation(110'000) == 110'000);
+        REQUIRE(timeline.predict_presentation(110'001) == 120'000);
+    }
+}
@@ -0,0 +1,49 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "idle_trim_timer.hpp"
+
+#include <chrono>
+
+using tobi_engine::IdleTrimTimer;
+using namespace std::chrono_literals;
+
+TEST_CASE("IdleTrimTimer counts down from the last repaint", "[idle_trim_timer]") {
+    const auto start = IdleTrimTimer::Clock::now();
+
+    SECTION("The window is due once the timeout passes without a repaint") {
+        IdleTrimTimer timer(5000, start);
+        REQUIRE(timer.get_timeout_ms(start) == 5000);
+        REQUIRE(timer.get_timeout_ms(start + 3s) == 2000);
+        REQUIRE(timer.get_timeout_ms(start + 5s) == 0);
+    }
+    SECTION("A repaint restarts the timer") {
+        IdleTrimTimer timer(5000, start);
+        timer.on_commit(true, start + 4s);
+        REQUIRE(timer.get_timeout_ms(start + 5s) == 4000);
+    }
+    SECTION("Commits without a new buffer do not count as activity") {
+        IdleTrimTimer timer(5000, start);
+        timer.on_commit(false, start + 4s);
+        REQUIRE(timer.get_timeout_ms(start + 5s) == 0);
+    }
+    SECTION("A zero timeout never trims") {
+        IdleTrimTimer timer(0, start);
+        REQUIRE(timer.get_timeout_ms(start + 1h) == -1);
+    }
+}
+
+TEST_CASE("IdleTrimTimer keeps suspended windows trimmed", "[idle_trim_timer]") {
+    const auto start = IdleTrimTimer::Clock::now();
+    IdleTrimTimer timer(5000, start);
+
+    // Suspending trims the window, and the configure is then acked with a bare commit.
+    timer.mark_trimmed();
+    timer.on_commit(false, start + 1s);
+    REQUIRE(timer.is_trimmed());
+    REQUIRE(timer.get_timeout_ms(start + 1s) == -1);
+
+    // The first frame drawn after resuming rebuilds the buffers.
+    timer.on_commit(true, start + 2s);
+    REQUIRE_FALSE(timer.is_trimmed());
+    REQUIRE(timer.get_timeout_ms(start + 2s) == 5000);
+}
@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "utils/pixel_kernels.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<uint32_t> random_premultiplied_pixels(size_t count, uint32_t seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<uint32_t> distribution(0, 255);
+
+        std::vector<uint32_t> pixels(count);
+        for (auto& pixel : pixels)
+        {
+            auto alpha = distribution(generator);
+            auto channel = [&]() { return distribution(generator) * alpha / 255; };
+            pixel = (alpha << 24) | (channel() << 16) | (channel() << 8) | channel();
+        }
+        // Make sure the edge cases are always covered.
+        pixels[0] = 0x00000000;
+        pixels[1 % count] = 0xFFFFFFFF;
+        return pixels;
+    }
+}
+
+// Odd sizes exercise the scalar tails, the large size exercises the streaming paths.
+static constexpr size_t TEST_SIZES[] = { 1, 3, 7, 16, 33, 1021, 300000 };
+
+TEST_CASE("Pixel kernels match the scalar reference", "[pixel_kernels]") {
+    const auto& reference = tobi_engine::PixelKernels::scalar();
+
+    for (auto kernels : tobi_engine::PixelKernels::available())
+    {
+        INFO("kernels: " << kernels->name);
+
+        for (auto size : TEST_SIZES)
+        {
+            INFO("size: " << size);
+
+            SECTION(std::string("fill ") + kernels->name + " " + std::to_string(size)) {
+                // Offset by one pixel so the destination is deliberately misaligned.
+                std::vector<uint32_t> expected(size + 1, 0), actual(size + 1, 0);
+                reference.fill(expected.data() + 1, size, 0xFF00DDDD);
+                kernels->fill(actual.data() + 1, size, 0xFF00DDDD);
+                REQUIRE(actual == expected);
+            }
+            SECTION(std::string("copy ") + kernels->name + " " + std::to_string(size)) {
+                auto source = random_premultiplied_pixels(size, 1);
+                std::vector<uint32_t> expected(size + 1, 0), actual(size + 1, 0);
+                reference.copy(expected.data() + 1, source.data(), size);
+                kernels->copy(actual.data() + 1, source.data(), size);
+                REQUIRE(actual == expected);
+            }
+            SECTION(std::string("blend_over ") + kernels->name + " " + std::to_string(size)) {
+                auto source = random_premultiplied_pixels(size, 2);
+                auto expected = random_premultiplied_pixels(size, 3);
+                auto actual = expected;
+                reference.blend_over(expected.data(), source.data(), size);
+                kernels->blend_over(actual.data(), source.data(), size);
+                REQUIRE(actual == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Scalar blend_over follows premultiplied source-over", "[pixel_kernels]") {
+    const auto& reference = tobi_engine::PixelKernels::scalar();
+
+    uint32_t destination[] = { 0xFF0000FF, 0xFF0000FF, 0x80402010 };
+    const uint32_t source[] = { 0xFFFF0000, 0x00000000, 0x80804020 };
+    reference.blend_over(destination, source, 3);
+
+    REQUIRE(destination[0] == 0xFFFF0000); // opaque source replaces
+    REQUIRE(destination[1] == 0xFF0000FF); // transparent source keeps the destination
+    REQUIRE(destination[2] == 0xC0A05028); // half over half
+}
+
+TEST_CASE("fill_rect and blit only touch the requested rectangle", "[pixel_kernels]") {
+    constexpr uint32_t stride = 16;
+    std::vector<uint32_t> pixels(stride * 8, 0);
+
+    tobi_engine::fill_rect(pixels.data(), stride, 2, 3, 5, 2, 0xFFFFFFFF);
+
+    for (uint32_t y = 0; y < 8; ++y)
+        for (uint32_t x = 0; x < stride; ++x)
+        {
+            bool inside = x >= 2 && x < 7 && y >= 3 && y < 5;
+            REQUIRE(pixels[y * stride + x] == (inside ? 0xFFFFFFFF : 0u));
+        }
+
+    std::vector<uint32_t> copy(4 * 2, 0);
+    tobi_engine::blit(copy.data(), 4, pixels.data() + 3 * stride + 1, stride, 4, 2);
+    REQUIRE(copy == std::vector<uint32_t>{ 0, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF });
+}
@@ -0,0 +1,136 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "pointer_frame_builder.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using tobi_engine::PointerFrame;
+using tobi_engine::PointerFrameBuilder;
+
+namespace
+{
+    // Records the frames it receives; everything else is unused by the builder.
+    class RecordingWindow : public tobi_engine::Window
+    {
+    public:
+        RecordingWindow() : Window(tobi_engine::WindowProperties{}) {}
+
+        void on_pointer_frame(const PointerFrame& frame) override { frames.push_back(frame); }
+
+        void update() override {}
+        bool should_close() override { return false; }
+        void request_redraw() override {}
+        auto get_frame_statistics() const -> tobi_engine::FrameStatistics override { return {}; }
+        void set_frame_pacing(tobi_engine::FramePacing) override {}
+        bool is_configured() override { return true; }
+        void on_key(uint32_t, uint32_t) override {}
+        void on_pointer_button(uint32_t, uint32_t) override {}
+        void on_pointer_motion(int32_t, int32_t) override {}
+
+        std::vector<PointerFrame> frames;
+
+    protected:
+        void wait_for_frame(std::coroutine_handle<>) override {}
+        void wait_for_configure(std::coroutine_handle<>) override {}
+
+    private:
+        void initialize() override {}
+    };
+
+    constexpr uint32_t BUTTON_LEFT = 0x110;
+}
+
+TEST_CASE("PointerFrameBuilder coalesces events into frames", "[pointer_frame_builder]") {
+    RecordingWindow window;
+    PointerFrameBuilder builder;
+    builder.set_window(&window);
+    builder.set_frame_events(true);
+
+    SECTION("Motions up to a frame event reach the window once, at the last position") {
+        for (uint32_t i = 1; i <= 10; ++i)
+            builder.motion(i, i * 1.5, i * 2.5);
+        REQUIRE(window.frames.empty());
+
+        builder.flush();
+        REQUIRE(window.frames.size() == 1);
+        REQUIRE(window.frames[0].moved);
+        REQUIRE(window.frames[0].x == 15.0);
+        REQUIRE(window.frames[0].y == 25.0);
+        REQUIRE(window.frames[0].time == 10);
+    }
+    SECTION("Scrolling accumulates within a frame") {
+        builder.axis_source(0);
+        builder.axis(1, 0, 10.0);
+        builder.axis_value120(0, 120);
+        builder.axis(2, 0, 5.0);
+        builder.axis_value120(0, 60);
+        builder.axis(2, 1, -3.0);
+        builder.axis_value120(1, -120);
+        builder.flush();
+
+        REQUIRE(window.frames.size() == 1);
+        const auto& frame = window.frames[0];
+        REQUIRE(frame.scrolled);
+        REQUIRE_FALSE(frame.moved);
+        REQUIRE(frame.axis[0] == 15.0);
+        REQUIRE(frame.axis[1] == -3.0);
+        REQUIRE(frame.axis_value120[0] == 180);
+        REQUIRE(frame.axis_value120[1] == -120);
+        REQUIRE(frame.axis_source == 0u);
+    }
+    SECTION("Axes beyond the known ones are ignored") {
+        builder.axis(1, 2, 10.0);
+        builder.axis_value120(2, 120);
+        builder.flush();
+        REQUIRE(window.frames.empty());
+    }
+    SECTION("Button changes keep their order and flush early when the frame is full") {
+        for (uint32_t i = 0; i < PointerFrame::MAX_BUTTONS + 2; ++i)
+            builder.button(i, BUTTON_LEFT + i, i % 2);
+        REQUIRE(window.frames.size() == 1);
+        REQUIRE(window.frames[0].button_count == PointerFrame::MAX_BUTTONS);
+
+        builder.flush();
+        REQUIRE(window.frames.size() == 2);
+        REQUIRE(window.frames[1].button_count == 2);
+        REQUIRE(window.frames[1].buttons[0].button == BUTTON_LEFT + PointerFrame::MAX_BUTTONS);
+        REQUIRE(window.frames[1].buttons[1].button == BUTTON_LEFT + PointerFrame::MAX_BUTTONS + 1);
+    }
+    SECTION("Empty frames are not delivered") {
+        builder.flush();
+        REQUIRE(window.frames.empty());
+    }
+    SECTION("A reset drops the pending frame") {
+        builder.motion(1, 1.0, 1.0);
+        builder.reset();
+        builder.flush();
+        REQUIRE(window.frames.empty());
+    }
+    SECTION("Without a window frames are dropped") {
+        builder.set_window(nullptr);
+        builder.motion(1, 1.0, 1.0);
+        builder.flush();
+        builder.set_window(&window);
+        builder.flush();
+        REQUIRE(window.frames.empty());
+    }
+}
+
+TEST_CASE("PointerFrameBuilder delivers every event without frame events", "[pointer_frame_builder]") {
+    RecordingWindow window;
+    PointerFrameBuilder builder;
+    builder.set_window(&window);
+
+    builder.enter(1.0, 2.0);
+    builder.motion(1, 3.0, 4.0);
+    builder.button(2, BUTTON_LEFT, 1);
+    builder.axis(3, 0, 10.0);
+
+    REQUIRE(window.frames.size() == 4);
+    REQUIRE(window.frames[0].x == 1.0);
+    REQUIRE(window.frames[1].x == 3.0);
+    REQUIRE(window.frames[2].button_count == 1);
+    REQUIRE_FALSE(window.frames[2].moved);
+    REQUIRE(window.frames[3].scrolled);
+}
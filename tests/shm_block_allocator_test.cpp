@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "shm_block_allocator.hpp"
+
+#include <cstddef>
+#include <vector>
+
+using tobi_engine::ShmBlock;
+using tobi_engine::ShmBlockAllocator;
+
+TEST_CASE("ShmBlockAllocator rounds requests to size classes", "[shm_block_allocator]") {
+    SECTION("Small requests take a page") {
+        REQUIRE(ShmBlockAllocator::size_class(1) == 4096);
+        REQUIRE(ShmBlockAllocator::size_class(4096) == 4096);
+        REQUIRE(ShmBlockAllocator::size_class(4097) == 8192);
+    }
+    SECTION("Classes are four steps per power of two") {
+        REQUIRE(ShmBlockAllocator::size_class(8193) == 12288);
+        REQUIRE(ShmBlockAllocator::size_class(1024 * 1024 + 1) == 1280 * 1024);
+        REQUIRE(ShmBlockAllocator::size_class(1920 * 1080 * 4) == 8 * 1024 * 1024);
+    }
+    SECTION("Classes are page aligned and waste at most a quarter") {
+        for (size_t size = 1; size < 64 * 1024 * 1024; size = size * 3 / 2 + 1)
+        {
+            auto rounded = ShmBlockAllocator::size_class(size);
+            REQUIRE(rounded >= size);
+            REQUIRE(rounded % ShmBlockAllocator::ALIGNMENT == 0);
+            REQUIRE(rounded <= size + size / 4 + ShmBlockAllocator::ALIGNMENT);
+        }
+    }
+}
+
+TEST_CASE("ShmBlockAllocator recycles and coalesces blocks", "[shm_block_allocator]") {
+    SECTION("A freed block is reused for the same class") {
+        ShmBlockAllocator blocks;
+        blocks.add(0, 64 * 1024 * 1024);
+        auto first = blocks.allocate(100'000);
+        blocks.allocate(100'000);
+        blocks.free(first);
+        REQUIRE(blocks.get_recycled_bytes() == first.size);
+
+        auto second = blocks.allocate(110'000);
+        REQUIRE(second.offset == first.offset);
+        REQUIRE(second.size == first.size);
+        REQUIRE(blocks.get_recycled_bytes() == 0);
+    }
+    SECTION("Bins hold at most MAX_RECYCLED_PER_CLASS blocks") {
+        ShmBlockAllocator blocks;
+        blocks.add(0, 64 * 1024 * 1024);
+        std::vector<ShmBlock> allocated;
+        for (size_t i = 0; i <= ShmBlockAllocator::MAX_RECYCLED_PER_CLASS; ++i)
+            allocated.push_back(blocks.allocate(4096));
+        for (const auto& block : allocated)
+            blocks.free(block);
+
+        REQUIRE(blocks.get_recycled_bytes() == ShmBlockAllocator::MAX_RECYCLED_PER_CLASS * 4096);
+        REQUIRE(blocks.get_free_blocks().count(allocated.back().offset) == 1);
+    }
+    SECTION("Bins hold at most MAX_RECYCLED_BYTES in total") {
+        ShmBlockAllocator blocks;
+        blocks.add(0, 64 * 1024 * 1024);
+        const size_t size = 16 * 1024 * 1024;
+        std::vector<ShmBlock> allocated;
+        for (int i = 0; i < 3; ++i)
+            allocated.push_back(blocks.allocate(size));
+        for (const auto& block : allocated)
+            blocks.free(block);
+
+        REQUIRE(blocks.get_recycled_bytes() == ShmBlockAllocator::MAX_RECYCLED_BYTES);
+        REQUIRE(blocks.get_free_blocks().count(allocated.back().offset) == 1);
+    }
+    SECTION("Flushing the bins coalesces everything back into one range") {
+        ShmBlockAllocator blocks;
+        blocks.add(0, 1024 * 1024);
+        std::vector<ShmBlock> allocated;
+        for (size_t size : { 4096, 8192, 12288, 4096, 65536 })
+            allocated.push_back(blocks.allocate(size));
+        for (const auto& block : allocated)
+            blocks.free(block);
+
+        blocks.flush_recycled();
+        REQUIRE(blocks.get_recycled_bytes() == 0);
+        REQUIRE(blocks.get_free_blocks().size() == 1);
+        REQUIRE(blocks.get_free_blocks().begin()->first == 0);
+        REQUIRE(blocks.get_free_blocks().begin()->second == 1024 * 1024);
+    }
+    SECTION("Binned blocks of other classes are flushed before giving up") {
+        ShmBlockAllocator blocks;
+        blocks.add(0, 3 * 4096);
+        std::vector<ShmBlock> allocated;
+        for (int i = 0; i < 3; ++i)
+            allocated.push_back(blocks.allocate(4096));
+        REQUIRE_FALSE(blocks.allocate(4096));
+        for (const auto& block : allocated)
+            blocks.free(block);
+
+        auto large = blocks.allocate(3 * 4096);
+        REQUIRE(large.offset == 0);
+        REQUIRE(large.size == 3 * 4096);
+        REQUIRE_FALSE(blocks.allocate(4096));
+    }
+    SECTION("Added ranges coalesce with a free tail") {
+        ShmBlockAllocator blocks;
+        blocks.add(0, 8192);
+        blocks.allocate(4096);
+        blocks.add(8192, 8192);
+        REQUIRE(blocks.get_free_blocks().size() == 1);
+        REQUIRE(blocks.allocate(12288).offset == 4096);
+    }
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "task_queue.hpp"
+
+#include <poll.h>
+#include <thread>
+#include <vector>
+
+using tobi_engine::TaskQueue;
+
+namespace
+{
+    bool is_readable(int fd)
+    {
+        pollfd descriptor { fd, POLLIN, 0 };
+        return poll(&descriptor, 1, 0) == 1;
+    }
+}
+
+TEST_CASE("TaskQueue runs posted tasks in order and signals its eventfd", "[task_queue]") {
+    SECTION("Nothing posted leaves the eventfd quiet") {
+        TaskQueue queue;
+        REQUIRE_FALSE(is_readable(queue.get_fd()));
+        REQUIRE(queue.run() == 0);
+    }
+    SECTION("Posting wakes the consumer until the queue is drained") {
+        TaskQueue queue;
+        std::vector<int> order;
+        queue.post([&order]() { order.push_back(1); });
+        queue.post([&order]() { order.push_back(2); });
+        REQUIRE(is_readable(queue.get_fd()));
+
+        REQUIRE(queue.run() == 2);
+        REQUIRE(order == std::vector<int>{ 1, 2 });
+        REQUIRE_FALSE(is_readable(queue.get_fd()));
+    }
+    SECTION("Tasks posted while running wait for the next run") {
+        TaskQueue queue;
+        int count = 0;
+        queue.post([&]() { ++count; queue.post([&count]() { ++count; }); });
+
+        REQUIRE(queue.run() == 1);
+        REQUIRE(is_readable(queue.get_fd()));
+        REQUIRE(queue.run() == 1);
+        REQUIRE(count == 2);
+    }
+    SECTION("Queues sharing an eventfd are drained by its owner") {
+        TaskQueue owner;
+        TaskQueue shared(owner.get_fd());
+        bool ran = false;
+        shared.post([&ran]() { ran = true; });
+        REQUIRE(is_readable(owner.get_fd()));
+
+        owner.run();
+        REQUIRE_FALSE(is_readable(owner.get_fd()));
+        REQUIRE(shared.run() == 1);
+        REQUIRE(ran);
+    }
+}
+
+TEST_CASE("TaskQueue accepts tasks from many producers", "[task_queue]") {
+    constexpr int PRODUCERS = 4;
+    constexpr int TASKS = 10'000;
+
+    TaskQueue queue;
+    std::vector<int> last(PRODUCERS, -1);
+    bool ordered = true;
+    size_t ran = 0;
+
+    {
+        std::vector<std::jthread> producers;
+        for (int producer = 0; producer < PRODUCERS; ++producer)
+        {
+            producers.emplace_back([&, producer]() {
+                for (int task = 0; task < TASKS; ++task)
+                    queue.post([&, producer, task]() {
+                        ordered &= last[producer] + 1 == task;
+                        last[producer] = task;
+                    });
+            });
+        }
+
+        while (ran < size_t(PRODUCERS) * TASKS)
+        {
+            pollfd descriptor { queue.get_fd(), POLLIN, 0 };
+            poll(&descriptor, 1, 100);
+            ran += queue.run();
+        }
+    }
+
+    REQUIRE(ordered);
+    REQUIRE(queue.run() == 0);
+}